@@ -78,6 +78,18 @@ blob& operator<<(blob& dest, const T& src)
     return dest;
 }
 
+/// Appends uppercase hexadecimal digits of the bytes to the string
+inline void append_hex(std::string& dest, blob_view src)
+{
+    static constexpr char Digits[] = "0123456789ABCDEF";
+    auto pos = dest.size();
+    dest.resize(pos + 2 * src.size());
+    for (auto byte : src) {
+        dest[pos++] = Digits[unsigned(byte) >> 4];
+        dest[pos++] = Digits[unsigned(byte) & 0xf];
+    }
+}
+
 /// I/O manipulator.
 
 /// Bytes inserted into the stream are expressed in hexadecimal base (radix 16)
@@ -86,11 +98,9 @@ struct hex {
 
     friend std::ostream& operator<<(std::ostream& dest, const hex& src)
     {
-        std::ostringstream os;
-        os << std::uppercase << std::hex << std::setfill('0');
-        for (auto byte : src.data)
-            os << std::setw(2) << static_cast<unsigned>(byte);
-        return dest << os.str();  // call stream once
+        std::string str;
+        append_hex(str, src.data);
+        return dest << str;  // call stream once
     }
 };
 
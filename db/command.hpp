@@ -6,6 +6,7 @@
 #include <bark/db/fwd.hpp>
 #include <bark/db/rowset.hpp>
 #include <bark/db/sql_builder.hpp>
+#include <bark/detail/trace.hpp>
 #include <boost/lexical_cast.hpp>
 #include <string>
 #include <vector>
@@ -31,6 +32,12 @@ struct command {
     /// @ref variant_ostream is populated with the row's values
     virtual bool fetch(variant_ostream&) = 0;
 
+    /// Streams the rows of the next queries instead of buffering whole
+    /// results on the client side, which suits large scans.
+
+    /// Drivers that always stream ignore it. Small queries may be slower.
+    virtual void set_streaming(bool) {}
+
     /// By default, each statement is automatically committed
     virtual void set_autocommit(bool) = 0;
 
@@ -45,6 +52,7 @@ inline sql_builder builder(command& cmd)
 
 inline void exec(command& cmd, const sql_builder& bld)
 {
+    BARK_TRACE_SCOPE("db::exec");
     cmd.exec(bld);
 }
 
@@ -56,10 +64,12 @@ void exec(command& cmd, const Sql& sql)
 
 inline rowset fetch_all(command& cmd)
 {
+    BARK_TRACE_SCOPE("db::fetch_all");
     auto cols = cmd.columns();
     variant_ostream os;
     while (cmd.fetch(os))
         ;
+    BARK_TRACE_COUNTER("db::fetched_bytes", os.data.size());
     return {std::move(cols), std::move(os.data)};
 }
 
@@ -0,0 +1,492 @@
+// Andrew Naplavkov
+
+#ifndef BARK_DB_COPIER_HPP
+#define BARK_DB_COPIER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bark/db/provider.hpp>
+#include <bark/detail/bounded_queue.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bark::db {
+
+/// Modifies the rows in place before they are written
+using rows_transform =
+    std::function<void(std::vector<std::vector<variant_t>>&)>;
+
+/// Makes a transform for every worker, so it need not be thread-safe
+using transform_factory = std::function<rows_transform()>;
+
+struct copying_options {
+    /// Parallel only if the primary key is a single integer. Other tables
+    /// are read by one reader, see @ref copying_stats::partitions.
+    unsigned readers = 1;
+    unsigned transformers = std::max(1u, std::thread::hardware_concurrency());
+    unsigned writers = 1;  ///< each one in its own transaction
+    size_t page = 10000;  ///< rows fetched at once
+    size_t batch = 0;  ///< rows per INSERT, zero to fit 999 parameters
+
+    /// Reads and writes in turn on one connection, implied if both tables
+    /// are of the same provider. A writer that locks the whole database,
+    /// like SQLite, would make the readers of other connections wait.
+    /// Without a primary key the table is scanned on its own connection,
+    /// so the rows are committed once, after the scan.
+    bool serial = false;
+
+    transform_factory transform;
+    std::function<void(size_t)> progress;  ///< rows written, after commits
+
+    /// Drops secondary indexes of the destination before the load and
+    /// creates them after it, by default if the destination is empty
+    std::optional<bool> rebuild_indexes;
+};
+
+struct copying_stats {
+    using duration = std::chrono::duration<double>;
+
+    size_t rows = 0;
+    size_t partitions = 0;  ///< key ranges, one if not read in parallel
+    duration reading{};  ///< summed over threads
+    duration transforming{};  ///< summed over threads
+    duration writing{};  ///< summed over threads
+    duration indexing{};  ///< dropping and creating the indexes
+    duration total{};
+
+    /// Throughput of the copy or of one thread of a stage
+    double rows_per_second(duration dur) const
+    {
+        auto secs = dur.count();
+        return secs > 0 ? rows / secs : 0;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const copying_stats& that)
+    {
+        auto stage = [&](const char* name, duration dur) -> std::ostream& {
+            return os << ", " << name << ": " << dur.count() << "s ("
+                      << that.rows_per_second(dur) << " rows/sec)";
+        };
+        os << std::fixed << std::setprecision(3) << "rows: " << that.rows
+           << ", partitions: " << that.partitions
+           << ", rows/sec: " << that.rows_per_second(that.total);
+        stage("reading", that.reading);
+        stage("transforming", that.transforming);
+        stage("writing", that.writing);
+        os << ", indexing: " << that.indexing.count() << "s";
+        return os << ", total: " << that.total.count() << "s";
+    }
+};
+
+namespace detail {
+
+struct key_range {
+    int64_t first;
+    int64_t last;
+};
+
+/// Splits the values of an integer key into ranges of equal width
+inline std::vector<key_range> key_ranges(provider& pvd,
+                                         const qualified_name& tbl_nm,
+                                         const std::string& key,
+                                         size_t count)
+{
+    auto rows = select(fetch_all(
+        pvd,
+        builder(pvd) << "SELECT MIN(" << id(key) << "), MAX(" << id(key)
+                     << ") FROM " << tbl_nm));
+    std::vector<key_range> res;
+    if (rows.size() != 1)
+        return res;
+    auto min = std::get_if<int64_t>(&rows.front()[0]);
+    auto max = std::get_if<int64_t>(&rows.front()[1]);
+    if (!min || !max)
+        return res;
+    auto width = (uint64_t(*max) - uint64_t(*min)) / count + 1;
+    for (auto first = *min;;) {
+        auto last = uint64_t(*max) - uint64_t(first) < width
+                        ? *max
+                        : int64_t(uint64_t(first) + width - 1);
+        res.push_back({first, last});
+        if (last == *max)
+            return res;
+        first = last + 1;
+    }
+}
+
+inline bool empty(provider& pvd, const qualified_name& tbl_nm)
+{
+    return row_count(fetch_all(pvd, select_sql(pvd, tbl_nm, 0, 1))) == 0;
+}
+
+/// Drops secondary indexes and creates them again on every exit path
+class index_deferral {
+public:
+    index_deferral(provider& pvd, const qualified_name& tbl_nm)
+        : pvd_(pvd), tbl_nm_(tbl_nm)
+    {
+    }
+
+    index_deferral(const index_deferral&) = delete;
+    index_deferral& operator=(const index_deferral&) = delete;
+
+    ~index_deferral()
+    {
+        if (dropped_.empty())
+            return;
+        for (auto& item : dropped_)  // made before the load
+            try {
+                exec(pvd_, item.second);
+            }
+            catch (...) {
+            }
+        try {
+            pvd_.refresh();
+        }
+        catch (...) {
+        }
+    }
+
+    void drop(const meta::table& tbl)
+    {
+        for (auto& idx : tbl.indexes) {
+            auto [drop, create] = pvd_.index_ddl(tbl, idx);
+            if (drop.empty())
+                continue;
+            dropped_.push_back({idx, std::move(create)});  // partial drops too
+            exec(pvd_, drop);
+        }
+        pvd_.refresh();
+    }
+
+    /// Creates the indexes with the statistics of the loaded rows
+    void rebuild()
+    {
+        if (dropped_.empty())
+            return;
+        pvd_.refresh();
+        auto tbl = pvd_.table(tbl_nm_);
+        while (!dropped_.empty()) {
+            exec(pvd_, pvd_.index_ddl(tbl, dropped_.back().first).second);
+            dropped_.pop_back();
+        }
+        pvd_.refresh();
+    }
+
+private:
+    provider& pvd_;
+    qualified_name tbl_nm_;
+    std::vector<std::pair<meta::index, std::string>> dropped_;
+};
+
+/// Keyset pagination inside the range of an integer key
+template <class Functor>
+void for_each_page(provider& pvd,
+                   const qualified_name& tbl_nm,
+                   const std::string& key,
+                   key_range rng,
+                   size_t limit,
+                   Functor f)
+{
+    auto tbl = pvd.table(tbl_nm);
+    auto key_idx =
+        std::distance(tbl.columns.begin(), db::find(tbl.columns, key));
+    auto cmd = pvd.make_command();
+    rowset page;
+    std::vector<variant_t> last_row;
+    for (;;) {
+        auto bld = builder(*cmd);
+        bld << "SELECT " << list{tbl.columns, ", ", decode} << " FROM "
+            << tbl_nm << " WHERE " << id(key) << " >= " << param{rng.first}
+            << " AND " << id(key) << " <= " << param{rng.last}
+            << " ORDER BY " << id(key) << " ";
+        pvd.page_clause(bld, 0, limit);
+        exec(*cmd, bld);
+        page.columns = cmd->columns();
+        auto rows = fetch_page(*cmd, limit, page, last_row);
+        if (!rows)
+            break;
+        auto last = std::get<int64_t>(last_row[key_idx]);
+        f(page);
+        if (rows < limit || last >= rng.last)
+            break;
+        rng.first = last + 1;
+    }
+}
+
+}  // namespace detail
+
+/// Copies rows between tables of the same or different providers.
+
+/// The pipeline has three stages connected with bounded queues, so memory
+/// does not depend on the size of the table. Readers fetch pages, in
+/// parallel from ranges of an integer primary key. Partitions by the
+/// spatial tiles of @ref provider::tile_coverage are not supported, since
+/// a feature may intersect several tiles. Without a primary key, the table
+/// is read by one scan, see @ref for_each_page. Transformers decode the
+/// pages, apply the transform and build INSERT statements. Writers execute
+/// them in their own transactions, committed periodically. More than one
+/// writer makes sense only if the destination accepts concurrent
+/// transactions. Tables of the same database are copied serially, see
+/// @ref copying_options::serial. Secondary indexes of an empty destination
+/// are created after the load, see @ref copying_options::rebuild_indexes.
+/// @code
+/// db::copy_table(src, src_tbl, cols, dest, dest_tbl, cols);
+/// @endcode
+/// @param from_cols are mapped to @p to_cols by position.
+inline copying_stats copy_table(provider& from,
+                                const qualified_name& from_tbl,
+                                const std::vector<std::string>& from_cols,
+                                provider& to,
+                                const qualified_name& to_tbl,
+                                const std::vector<std::string>& to_cols,
+                                const copying_options& opts = {})
+{
+    using namespace std::chrono;
+    using clock = steady_clock;
+    static constexpr auto CommitInterval = seconds(3);
+    static constexpr size_t MaxVariableNumber = 999;  // sqlite limit
+
+    copying_stats res;
+    auto start = clock::now();
+    auto readers = std::max(1u, opts.readers);
+    auto transformers = std::max(1u, opts.transformers);
+    auto writers = std::max(1u, opts.writers);
+    auto page_size = std::max<size_t>(1, opts.page);
+    auto vars = std::max<size_t>(1, to_cols.size());
+    auto batch =
+        opts.batch ? opts.batch : std::max<size_t>(1, MaxVariableNumber / vars);
+
+    auto tbl = from.table(from_tbl);
+    detail::index_deferral deferral(to, to_tbl);
+    bool rebuild = opts.rebuild_indexes ? *opts.rebuild_indexes
+                                        : detail::empty(to, to_tbl);
+    if (rebuild) {
+        auto first = clock::now();
+        deferral.drop(to.table(to_tbl));
+        res.indexing += clock::now() - first;
+    }
+    to.table(to_tbl);  // cached before the threads start
+    auto pri =
+        boost::range::find_if(tbl.indexes, same{meta::index_type::Primary});
+    std::string key;
+    std::vector<detail::key_range> ranges;
+    auto serial = opts.serial || &from == &to;
+    if (!serial && readers > 1 && pri != tbl.indexes.end() &&
+        pri->columns.size() == 1 &&
+        db::find(tbl.columns, pri->columns.front())->type ==
+            meta::column_type::Integer) {
+        key = pri->columns.front();
+        ranges = detail::key_ranges(from, from_tbl, key, readers * 4);
+    }
+    if (ranges.empty())
+        readers = 1;
+    res.partitions = std::max<size_t>(1, ranges.size());
+
+    bounded_queue<rowset> pages(transformers * 2);
+    bounded_queue<std::pair<size_t, sql_builder>> batches(writers * 4);
+    std::mutex guard;
+    std::exception_ptr error;
+    std::atomic<clock::duration::rep> reading{0};
+    std::atomic<clock::duration::rep> transforming{0};
+    std::atomic<clock::duration::rep> writing{0};
+    std::atomic<size_t> written{0};
+    auto fail = [&] {
+        {
+            auto lock = std::lock_guard{guard};
+            if (!error)
+                error = std::current_exception();
+        }
+        pages.close();
+        batches.close();
+    };
+    auto failed = [&] {
+        auto lock = std::lock_guard{guard};
+        return !!error;
+    };
+    auto notify = [&] {
+        if (opts.progress) {
+            auto lock = std::lock_guard{guard};
+            opts.progress(written);
+        }
+    };
+    std::vector<std::thread> threads;
+
+    if (serial)
+        threads.emplace_back([&] {
+            try {
+                auto tf = opts.transform ? opts.transform() : rows_transform{};
+                auto cmd = to.make_command();
+                cmd->set_autocommit(false);
+                auto last_commit = clock::now();
+                auto first = clock::now();
+                auto lap = [&](auto& stage) {
+                    auto now = clock::now();
+                    stage += (now - first).count();
+                    first = now;
+                };
+                auto keyset = pri != tbl.indexes.end();
+                auto write = [&](const rowset& page) {
+                    lap(reading);
+                    auto rows = select(from_cols, page);
+                    if (tf)
+                        tf(rows);
+                    for (size_t pos = 0; pos < rows.size(); pos += batch) {
+                        auto slice = boost::make_iterator_range(
+                            rows.begin() + pos,
+                            rows.begin() + std::min(rows.size(), pos + batch));
+                        auto sql = insert_sql(to, to_tbl, to_cols, slice);
+                        lap(transforming);
+                        exec(*cmd, sql);
+                        written += slice.size();
+                        lap(writing);
+                    }
+                    if (keyset && first - last_commit > CommitInterval) {
+                        cmd->commit();
+                        last_commit = clock::now();
+                        lap(writing);
+                        notify();
+                    }
+                };
+                if (keyset) {
+                    auto key_idxs =
+                        as<std::vector<size_t>>(pri->columns, [&](auto& col) {
+                            return std::distance(tbl.columns.begin(),
+                                                 db::find(tbl.columns, col));
+                        });
+                    detail::for_each_key_page(
+                        from, *cmd, from_tbl, key_idxs, page_size, write);
+                }
+                else  // a commit would wait for the scan to finish
+                    for_each_page(from, from_tbl, page_size, write);
+                cmd->commit();
+                lap(writing);
+                notify();
+            }
+            catch (...) {
+                fail();
+            }
+        });
+    else {
+        std::atomic<size_t> next_range{0};
+        std::atomic<unsigned> reading_threads{readers};
+        for (unsigned i = 0; i < readers; ++i)
+            threads.emplace_back([&] {
+                try {
+                    auto first = clock::now();
+                    auto push = [&](const rowset& page) {
+                        reading += (clock::now() - first).count();
+                        if (!pages.push(page))
+                            throw std::runtime_error("copying aborted");
+                        first = clock::now();
+                    };
+                    if (ranges.empty())
+                        for_each_page(from, from_tbl, page_size, push);
+                    for (size_t idx; (idx = next_range++) < ranges.size();)
+                        detail::for_each_page(
+                            from, from_tbl, key, ranges[idx], page_size, push);
+                }
+                catch (...) {
+                    fail();
+                }
+                if (!--reading_threads)
+                    pages.close();
+            });
+
+        std::atomic<unsigned> transforming_threads{transformers};
+        for (unsigned i = 0; i < transformers; ++i)
+            threads.emplace_back([&] {
+                try {
+                    auto tf =
+                        opts.transform ? opts.transform() : rows_transform{};
+                    while (auto page = pages.pop()) {
+                        auto first = clock::now();
+                        auto rows = select(from_cols, *page);
+                        if (tf)
+                            tf(rows);
+                        for (size_t pos = 0; pos < rows.size(); pos += batch) {
+                            auto slice = boost::make_iterator_range(
+                                rows.begin() + pos,
+                                rows.begin() +
+                                    std::min(rows.size(), pos + batch));
+                            auto sql = insert_sql(to, to_tbl, to_cols, slice);
+                            transforming += (clock::now() - first).count();
+                            if (!batches.push({slice.size(), std::move(sql)}))
+                                throw std::runtime_error("copying aborted");
+                            first = clock::now();
+                        }
+                    }
+                }
+                catch (...) {
+                    fail();
+                }
+                if (!--transforming_threads)
+                    batches.close();
+            });
+
+        for (unsigned i = 0; i < writers; ++i)
+            threads.emplace_back([&] {
+                try {
+                    auto cmd = to.make_command();
+                    cmd->set_autocommit(false);
+                    auto last_commit = clock::now();
+                    while (auto item = batches.pop()) {
+                        auto first = clock::now();
+                        exec(*cmd, item->second);
+                        written += item->first;
+                        if (first - last_commit > CommitInterval) {
+                            cmd->commit();
+                            last_commit = clock::now();
+                            notify();
+                        }
+                        writing += (clock::now() - first).count();
+                    }
+                    if (failed())
+                        return;
+                    auto first = clock::now();
+                    cmd->commit();
+                    writing += (clock::now() - first).count();
+                    notify();
+                }
+                catch (...) {
+                    fail();
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+    if (rebuild) {
+        auto first = clock::now();
+        try {
+            deferral.rebuild();
+        }
+        catch (...) {
+            if (!error)
+                error = std::current_exception();
+        }
+        res.indexing += clock::now() - first;
+    }
+    if (error)
+        std::rethrow_exception(error);
+    res.rows = written;
+    res.reading = clock::duration(reading.load());
+    res.transforming = clock::duration(transforming.load());
+    res.writing = clock::duration(writing.load());
+    res.total = clock::now() - start;
+    return res;
+}
+
+}  // namespace bark::db
+
+#endif  // BARK_DB_COPIER_HPP
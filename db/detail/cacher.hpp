@@ -6,11 +6,19 @@
 #include <algorithm>
 #include <atomic>
 #include <bark/db/provider.hpp>
+#include <bark/db/wkb_decoder.hpp>
 #include <bark/detail/lru_cache.hpp>
 #include <bark/geometry/geometry.hpp>
 #include <bark/proj/bimap.hpp>
 #include <boost/functional/hash.hpp>
+#include <boost/range/adaptor/map.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
 #include <tuple>
+#include <unordered_set>
+#include <vector>
 
 namespace bark::db {
 
@@ -42,6 +50,24 @@ protected:
             scope_, tbl_nm, [&] { return as_mixin().load_table(tbl_nm); }));
     }
 
+    /// Shared by the tables, so it is not copied
+    auto cached_catalog()
+    {
+        using result_type = decltype(as_mixin().load_catalog());
+        return std::any_cast<result_type>(lru_cache::get_or_invoke(
+            scope_, Catalog, [&] { return as_mixin().load_catalog(); }));
+    }
+
+    /// Shared by the columns, so it is not copied
+    auto cached_geometry_columns()
+    {
+        using result_type = decltype(as_mixin().load_geometry_columns());
+        return std::any_cast<result_type>(
+            lru_cache::get_or_invoke(scope_, GeometryColumns, [&] {
+                return as_mixin().load_geometry_columns();
+            }));
+    }
+
     geometry::multi_box cached_tiles_first(const qualified_name& lr_nm,
                                            const geometry::box& ext,
                                            const geometry::box& px)
@@ -63,10 +89,39 @@ protected:
                                   const geometry::box& ext,
                                   const geometry::box& px)
     {
-        return std::any_cast<rowset>(
-            lru_cache::get_or_invoke(scope_, layer_tile{lr_nm, ext}, [&] {
-                return as_mixin().load_spatial_objects(lr_nm, ext, px);
-            }));
+        return cached_tile(lr_nm, ext, px)->objects;
+    }
+
+    /// Answers from the cached tiles that cover the extent, so extent and
+    /// point queries do not reach the data source. Otherwise the extent is
+    /// loaded and cached like a tile.
+    rowset cached_vector_objects(const qualified_name& lr_nm,
+                                 const geometry::box& ext,
+                                 const geometry::box& px)
+    {
+        if (!lru_cache::contains(scope_, layer_tile{lr_nm, ext}))
+            if (auto res = find_cached_objects(lr_nm, ext, px))
+                return std::move(*res);
+        return cached_spatial_objects(lr_nm, ext, px);
+    }
+
+    /// Features that intersect the extent exactly. Cached tiles are tried
+    /// first, otherwise the narrow window is loaded past the cache, so
+    /// picking on every mouse move does not evict the tiles.
+    /// @param load is false for the sources that are too slow to query.
+    rowset cached_pick(const qualified_name& lr_nm,
+                       const geometry::box& ext,
+                       const geometry::box& px,
+                       bool load = true)
+    {
+        auto res = find_cached_objects(lr_nm, ext, px);
+        if (!res) {
+            if (!load)
+                return {};
+            res = as_mixin().load_spatial_objects(lr_nm, ext, px);
+        }
+        return res->columns.empty() ? std::move(*res)
+                                    : intersecting_rows(*res, 0, ext);
     }
 
     std::string cached_schema()
@@ -80,7 +135,47 @@ protected:
     void reset_cache() { scope_ = lru_cache::new_scope(); }
 
 private:
-    enum keys { CurrentSchema, Dir, ProjectionBimap };
+    enum keys { Catalog, CurrentSchema, Dir, GeometryColumns, ProjectionBimap };
+
+    /// Spatial objects of a tile with their feature index, so the index
+    /// never outlives the rows it numbers
+    struct tile_objects {
+        const rowset objects;
+
+        explicit tile_objects(rowset&& rs) : objects{std::move(rs)} {}
+
+        /// Built on the first sub-query of the tile
+        const tile_objects& indexed() const
+        {
+            std::call_once(flag_, [&] {
+                detail::append_offsets(objects.data, offsets_);
+                features_ = make_feature_index(objects, 0);
+            });
+            return *this;
+        }
+
+        /// Requires @ref indexed
+        blob_view row_data(size_t row) const
+        {
+            auto cols = objects.columns.size();
+            auto pos = offsets_[row * cols];
+            auto last = offsets_[(row + 1) * cols];
+            return {objects.data.data() + pos, last - pos};
+        }
+
+        /// Requires @ref indexed
+        const geometry::numbered_box_rtree& features() const
+        {
+            return features_;
+        }
+
+    private:
+        mutable std::once_flag flag_;
+        mutable std::vector<size_t> offsets_;
+        mutable geometry::numbered_box_rtree features_;
+    };
+
+    using tile_objects_ptr = std::shared_ptr<const tile_objects>;
 
     struct layer_tile {
         qualified_name name;
@@ -107,6 +202,60 @@ private:
     };
 
     std::atomic<lru_cache::scope_type> scope_;
+
+    /// Shared by the queries of the tile, so its rows are not copied
+    tile_objects_ptr cached_tile(const qualified_name& lr_nm,
+                                 const geometry::box& tile,
+                                 const geometry::box& px)
+    {
+        return std::any_cast<tile_objects_ptr>(
+            lru_cache::get_or_invoke(scope_, layer_tile{lr_nm, tile}, [&] {
+                return std::make_shared<const tile_objects>(
+                    as_mixin().load_spatial_objects(lr_nm, tile, px));
+            }));
+    }
+
+    /// Features of the cached tiles with envelopes intersecting the extent
+    std::optional<rowset> find_cached_objects(const qualified_name& lr_nm,
+                                              const geometry::box& ext,
+                                              const geometry::box& px)
+    try {
+        auto tiles = as_mixin().make_tile_coverage(lr_nm, ext, px);
+        if (tiles.empty())
+            return std::nullopt;
+        for (auto& tile : tiles)
+            if (!lru_cache::contains(scope_, layer_tile{lr_nm, tile}))
+                return std::nullopt;
+
+        std::optional<rowset> res;
+        variant_ostream os;
+        std::unordered_set<std::string_view> unique;  // shared features
+        std::vector<tile_objects_ptr> objects;  // own the unique keys
+        for (auto& tile : tiles) {
+            auto& ptr = objects.emplace_back(cached_tile(lr_nm, tile, px));
+            auto& tl = ptr->indexed();
+            if (!res)
+                res = rowset{tl.objects.columns, {}};
+            std::vector<geometry::numbered_box> hits;
+            tl.features().query(boost::geometry::index::intersects(ext),
+                                std::back_inserter(hits));
+            std::sort(hits.begin(), hits.end(), [](auto& lhs, auto& rhs) {
+                return lhs.second < rhs.second;
+            });
+            for (auto row : hits | boost::adaptors::map_values) {
+                auto data = tl.row_data(row);
+                auto key = std::string_view{
+                    reinterpret_cast<const char*>(data.data()), data.size()};
+                if (unique.insert(key).second)
+                    os.data.insert(os.data.end(), data.begin(), data.end());
+            }
+        }
+        res->data = std::move(os.data);
+        return res;
+    }
+    catch (const busy_exception&) {
+        return std::nullopt;
+    }
 };
 
 }  // namespace bark::db
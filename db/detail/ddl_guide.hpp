@@ -25,7 +25,30 @@ protected:
         create_table_sql(bld, tbl);
         add_geometry_columns_sql(bld, tbl);
         create_indexes_sql(bld, tbl);
-        return {tbl.name, bld.sql()};
+        return {tbl.name, std::string{bld.sql()}};
+    }
+
+    /// Commands that drop and create a secondary index around a bulk load,
+    /// empty if the index is not named like the ones of @ref script, so it
+    /// may back a constraint.
+    std::pair<std::string, std::string> index_script(const meta::table& tbl,
+                                                     const meta::index& idx)
+    {
+        if (idx.type != meta::index_type::Secondary || idx.name.empty() ||
+            idx.name.back() != index_name(tbl.name.back(), idx.columns).back())
+            return {};
+        auto& dial = as_mixin().as_dialect();
+        auto quote = as_mixin().make_command()->quoted_identifier();
+        auto drop = sql_builder{quote, nullptr};
+        auto& col = *db::find(tbl.columns, idx.columns.front());
+        if (col.type == meta::column_type::Geometry)
+            dial.drop_spatial_index_sql(drop, id(tbl.name, col.name), idx.name);
+        else
+            dial.drop_index_sql(drop, tbl.name, idx.name);
+        drop << ";\n";
+        auto create = sql_builder{quote, nullptr};
+        create_index_sql(create, tbl, idx);
+        return {std::string{drop.sql()}, std::string{create.sql()}};
     }
 
 private:
@@ -85,17 +108,25 @@ private:
     void create_indexes_sql(sql_builder& bld, const meta::table& tbl)
     {
         for (auto& idx : tbl.indexes | boost::adaptors::filtered(
-                                           same{meta::index_type::Secondary})) {
-            auto& col = *db::find(tbl.columns, idx.columns.front());
-            if (col.type == meta::column_type::Geometry)
-                as_mixin().as_dialect().create_spatial_index_sql(
-                    bld, id(tbl.name, col.name), geometry::envelope(col.tiles));
-            else
-                bld << "CREATE INDEX "
-                    << index_name(tbl.name.back(), idx.columns) << " ON "
-                    << tbl.name << " (" << list{idx.columns, ", ", id<>} << ")";
-            bld << ";\n";
-        }
+                                           same{meta::index_type::Secondary}))
+            create_index_sql(bld, tbl, idx);
+    }
+
+    void create_index_sql(sql_builder& bld,
+                          const meta::table& tbl,
+                          const meta::index& idx)
+    {
+        auto& col = *db::find(tbl.columns, idx.columns.front());
+        if (col.type == meta::column_type::Geometry)
+            as_mixin().as_dialect().create_spatial_index_sql(
+                bld,
+                id(tbl.name, col.name),
+                geometry::envelope(*col.tiles.get()));
+        else
+            bld << "CREATE INDEX " << index_name(tbl.name.back(), idx.columns)
+                << " ON " << tbl.name << " (" << list{idx.columns, ", ", id<>}
+                << ")";
+        bld << ";\n";
     }
 };
 
@@ -7,6 +7,7 @@
 #include <bark/db/sql_builder.hpp>
 #include <bark/geometry/geometry.hpp>
 #include <memory>
+#include <vector>
 
 namespace bark::db {
 
@@ -28,6 +29,28 @@ struct dialect {
     /// INDEX_SCHEMA, INDEX_NAME, COLUMN_NAME, IS_PRIMARY, IS_DESCENDING
     virtual void indexes_sql(sql_builder&, const qualified_name& tbl_nm) = 0;
 
+    /// TABLE_SCHEMA, TABLE_NAME, COLUMN_NAME, DATA_TYPE, NUMERIC_SCALE.
+    /// @return false if the tables can not be described by one query
+    virtual bool batch_columns_sql(sql_builder&,
+                                   const std::vector<qualified_name>&)
+    {
+        return false;
+    }
+
+    /// TABLE_SCHEMA, TABLE_NAME, INDEX_SCHEMA, INDEX_NAME, COLUMN_NAME,
+    /// IS_PRIMARY, IS_DESCENDING.
+    /// @return false if the tables can not be described by one query
+    virtual bool batch_indexes_sql(sql_builder&,
+                                   const std::vector<qualified_name>&)
+    {
+        return false;
+    }
+
+    /// TABLE_SCHEMA, TABLE_NAME, COLUMN_NAME, SRID, COUNT, EXTENT.
+    /// COUNT and EXTENT are estimated from statistics or NULL if unknown.
+    /// @return false if the catalog does not provide them
+    virtual bool geometry_columns_sql(sql_builder&) { return false; }
+
     /// SRID
     virtual void projection_sql(sql_builder&, const qualified_name& col_nm) = 0;
 
@@ -42,6 +65,20 @@ struct dialect {
                                           const qualified_name& col_nm,
                                           const geometry::box&) = 0;
 
+    virtual void drop_index_sql(sql_builder& bld,
+                                const qualified_name& /*tbl_nm*/,
+                                const qualified_name& idx_nm)
+    {
+        bld << "DROP INDEX " << idx_nm;
+    }
+
+    virtual void drop_spatial_index_sql(sql_builder& bld,
+                                        const qualified_name& col_nm,
+                                        const qualified_name& idx_nm)
+    {
+        drop_index_sql(bld, qualifier(col_nm), idx_nm);
+    }
+
     virtual void window_clause(sql_builder&,
                                const meta::table& tbl,
                                std::string_view col_nm,
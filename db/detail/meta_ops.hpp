@@ -5,10 +5,13 @@
 
 #include <bark/db/meta.hpp>
 #include <bark/detail/grid.hpp>
+#include <bark/geometry/envelope.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/range/algorithm/find_if.hpp>
 #include <boost/range/algorithm/search.hpp>
 #include <cmath>
+#include <optional>
+#include <string_view>
 
 namespace bark::db {
 
@@ -57,9 +60,11 @@ auto names(Columns&& cols)
                                         [&](auto& col) { return col.name; });
 }
 
+/// Rows in a tile of the balanced grid
+inline constexpr size_t RowsPerTile = 2000;
+
 inline geometry::box_rtree make_tiles(size_t count, geometry::box ext)
 {
-    constexpr size_t RowsPerTile = 2000;
     geometry::box_rtree res;
     if (count) {
         auto side = size_t(ceil(sqrt(count / double(RowsPerTile))));
@@ -72,6 +77,29 @@ inline geometry::box_rtree make_tiles(size_t count, geometry::box ext)
     return res;
 }
 
+/// Estimates of a geometry column for the choice of a query plan
+struct column_statistics {
+    size_t rows = 0;  ///< upper bound, from the number of tiles
+    geometry::box extent;
+    bool indexed = false;  ///< has a spatial index
+};
+
+/// Never blocks, nothing if the tile grid is not known yet
+inline std::optional<column_statistics> statistics(const meta::table& tbl,
+                                                   std::string_view col_nm)
+{
+    auto col = db::find(tbl.columns, col_nm);
+    if (col == tbl.columns.end())
+        return std::nullopt;
+    auto tiles = col->tiles.current();
+    if (!tiles)
+        return std::nullopt;
+    auto cols = {col_nm};
+    return column_statistics{tiles->size() * RowsPerTile,
+                             geometry::envelope(*tiles),
+                             indexed(tbl.indexes, cols)};
+}
+
 }  // namespace bark::db
 
 #endif  // BARK_DB_META_OPS_HPP
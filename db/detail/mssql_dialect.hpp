@@ -138,6 +138,13 @@ struct mssql_dialect : dialect {
             << ", @level2name = " << param{col};
     }
 
+    void drop_index_sql(sql_builder& bld,
+                        const qualified_name& tbl_nm,
+                        const qualified_name& idx_nm) override
+    {
+        bld << "DROP INDEX " << id(idx_nm.back()) << " ON " << tbl_nm;
+    }
+
     void create_spatial_index_sql(sql_builder& bld,
                                   const qualified_name& col_nm,
                                   const geometry::box& ext) override
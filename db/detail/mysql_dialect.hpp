@@ -30,6 +30,13 @@ struct mysql_dialect : dialect {
         iso_columns_sql(bld, tbl_nm);
     }
 
+    bool batch_columns_sql(sql_builder& bld,
+                           const std::vector<qualified_name>& tbl_nms) override
+    {
+        iso_batch_columns_sql(bld, tbl_nms);
+        return true;
+    }
+
     meta::column_type type(std::string_view type, int scale) override
     {
         if (is_ogc_type(type))
@@ -64,6 +71,28 @@ struct mysql_dialect : dialect {
             << ") ORDER BY is_primary DESC, index_name, seq_in_index";
     }
 
+    bool batch_indexes_sql(sql_builder& bld,
+                           const std::vector<qualified_name>& tbl_nms) override
+    {
+        bld << "SELECT table_schema, table_name, NULL, index_name, "
+               "column_name, index_name = "
+            << param{"PRIMARY"} << " AS is_primary, collation = " << param{"D"}
+            << " FROM information_schema.statistics WHERE (table_schema, "
+               "table_name) IN (";
+        schema_table_list(bld, tbl_nms);
+        bld << ") ORDER BY table_schema, table_name, is_primary DESC, "
+               "index_name, seq_in_index";
+        return true;
+    }
+
+    /// No statistics of geometries, only spatial reference systems
+    bool geometry_columns_sql(sql_builder& bld) override
+    {
+        bld << "SELECT table_schema, table_name, column_name, srs_id, NULL, "
+               "NULL FROM information_schema.st_geometry_columns";
+        return true;
+    }
+
     sql_decoder geom_decoder() override
     {
         return [](sql_builder& bld, std::string_view col_nm) {
@@ -131,6 +160,13 @@ FROM (SELECT ST_ExteriorRing(ST_Envelope(ST_GeomFromWKB(ST_AsBinary()"
             << id(col_nm.back()) << " GEOMETRY NOT NULL SRID " << srid;
     }
 
+    void drop_index_sql(sql_builder& bld,
+                        const qualified_name& tbl_nm,
+                        const qualified_name& idx_nm) override
+    {
+        bld << "DROP INDEX " << id(idx_nm.back()) << " ON " << tbl_nm;
+    }
+
     void create_spatial_index_sql(sql_builder& bld,
                                   const qualified_name& col_nm,
                                   const geometry::box&) override
@@ -38,6 +38,8 @@ struct mysql_old_dialect : mysql_dialect {
             << ") AND LOWER(column_name) = LOWER(" << param{col} << "))";
     }
 
+    bool geometry_columns_sql(sql_builder&) override { return false; }
+
     sql_decoder geom_decoder() override { return st_as_binary(); }
 
     sql_encoder geom_encoder(std::string_view, int srid) override
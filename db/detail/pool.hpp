@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <bark/db/command.hpp>
+#include <bark/detail/trace.hpp>
 #include <exception>
 #include <functional>
 #include <memory>
@@ -21,12 +22,15 @@ public:
 
     command_holder make_command()
     {
+        BARK_TRACE_SCOPE("db::pool::make_command");
         auto self = shared_from_this();
         auto deleter = [self](command* cmd) { self->push(cmd); };
         auto res = command_holder(nullptr, deleter);
         auto lock = std::lock_guard{guard_};
-        if (commands_.empty())
+        if (commands_.empty()) {
+            BARK_TRACE_COUNTER("db::pool::connections", 1);
             res.reset(alloc_());
+        }
         else {
             res.reset(commands_.front().release());
             commands_.pop();  // no-throw guarantee
@@ -35,6 +35,20 @@ struct postgres_dialect : dialect {
             << " ORDER BY ordinal_position";
     }
 
+    bool batch_columns_sql(sql_builder& bld,
+                           const std::vector<qualified_name>& tbl_nms) override
+    {
+        bld << "SELECT table_schema, table_name, column_name, LOWER(CASE "
+               "data_type WHEN "
+            << param{"USER-DEFINED"}
+            << " THEN udt_name ELSE data_type END), numeric_scale FROM "
+               "information_schema.columns WHERE (table_schema, table_name) "
+               "IN (";
+        schema_table_list(bld, tbl_nms);
+        bld << ") ORDER BY table_schema, table_name, ordinal_position";
+        return true;
+    }
+
     meta::column_type type(std::string_view type, int scale) override
     {
         if (within(type)("array"))
@@ -93,6 +107,51 @@ ORDER BY pri DESC, scm, nm, col
 )";
     }
 
+    bool batch_indexes_sql(sql_builder& bld,
+                           const std::vector<qualified_name>& tbl_nms) override
+    {
+        bld << R"(
+WITH indexes AS (
+  SELECT s.nspname scm, t.oid tbl, t.relname tbl_nm, o.relname nm,
+         i.indisprimary pri, i.indkey cols, i.indoption opts,
+         array_lower(i.indkey, 1) lb, array_upper(i.indkey, 1) ub
+  FROM pg_index i, pg_class o, pg_class t, pg_namespace s
+  WHERE i.indexrelid = o.oid
+    AND i.indrelid = t.oid
+    AND t.relnamespace = s.oid
+    AND (s.nspname, t.relname) IN ()";
+        schema_table_list(bld, tbl_nms);
+        bld << R"()
+), columns AS (
+  SELECT indexes.*, generate_series(lb, ub) col FROM indexes
+)
+SELECT scm, tbl_nm, scm, nm, attname, pri, (opts[col] & 1)
+FROM columns, pg_attribute
+WHERE attrelid = tbl
+AND attnum = cols[col]
+ORDER BY scm, tbl_nm, pri DESC, nm, col
+)";
+        return true;
+    }
+
+    /// Row count and extent come from the planner statistics
+    bool geometry_columns_sql(sql_builder& bld) override
+    {
+        bld << R"(
+SELECT g.f_table_schema, g.f_table_name, g.f_geometry_column, g.srid,
+       CASE WHEN c.reltuples > 0 THEN c.reltuples::bigint END,
+       CASE WHEN c.reltuples > 0 THEN ST_AsBinary(ST_EstimatedExtent(
+         g.f_table_schema, g.f_table_name, g.f_geometry_column)::geometry) END
+FROM geometry_columns g
+LEFT JOIN pg_namespace n ON n.nspname = g.f_table_schema
+LEFT JOIN pg_class c ON c.relnamespace = n.oid AND c.relname = g.f_table_name
+UNION ALL
+SELECT f_table_schema, f_table_name, f_geography_column, srid, NULL, NULL
+FROM geography_columns
+)";
+        return true;
+    }
+
     sql_decoder geom_decoder() override { return st_as_binary(); }
 
     sql_encoder geom_encoder(std::string_view type, int srid) override
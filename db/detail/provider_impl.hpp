@@ -6,13 +6,32 @@
 #include <bark/db/detail/dialect.hpp>
 #include <bark/db/detail/pool.hpp>
 #include <bark/db/detail/utility.hpp>
+#include <bark/detail/executor.hpp>
 #include <bark/geometry/geom_from_wkb.hpp>
 #include <boost/lexical_cast.hpp>
 #include <exception>
+#include <map>
 #include <memory>
+#include <optional>
 
 namespace bark::db {
 
+/// Spatial reference and estimated tiles of a geometry column
+struct geometry_column_info {
+    int srid = 0;
+    std::optional<geometry::box_rtree> tiles;  ///< if statistics are known
+};
+
+using geometry_columns_ptr =
+    std::shared_ptr<const std::map<qualified_name, geometry_column_info>>;
+
+/// Computes metadata that is not needed at once, e.g. exact extents
+inline executor& background_executor()
+{
+    return shared_executors::instance().get(
+        shared_executors::pool::Background);
+}
+
 template <class T>
 class provider_impl : public db::provider {
     T& as_mixin() { return static_cast<T&>(*this); }
@@ -36,7 +55,7 @@ public:
 
     geometry::box extent(const qualified_name& lr_nm) override
     {
-        return geometry::envelope(column(*this, lr_nm).tiles);
+        return geometry::envelope(*layer_tiles(lr_nm));
     }
 
     geometry::box undistorted_pixel(const qualified_name&,
@@ -56,7 +75,14 @@ public:
                            const geometry::box& ext,
                            const geometry::box& px) override
     {
-        return as_mixin().cached_spatial_objects(lr_nm, ext, px);
+        return as_mixin().cached_vector_objects(lr_nm, ext, px);
+    }
+
+    rowset pick(const qualified_name& lr_nm,
+                const geometry::box& ext,
+                const geometry::box& px) override
+    {
+        return as_mixin().cached_pick(lr_nm, ext, px);
     }
 
     command_holder make_command() override { return pool_->make_command(); }
@@ -71,6 +97,13 @@ public:
         return as_mixin().script(tbl);
     }
 
+    std::pair<std::string, std::string> index_ddl(
+        const meta::table& tbl,
+        const meta::index& idx) override
+    {
+        return as_mixin().index_script(tbl, idx);
+    }
+
     void page_clause(sql_builder& bld, size_t offset, size_t limit) override
     {
         as_dialect().page_clause(bld, offset, limit);
@@ -104,9 +137,8 @@ protected:
                                            const geometry::box&)
     {
         geometry::multi_box res;
-        column(*this, lr_nm)
-            .tiles.query(boost::geometry::index::intersects(ext),
-                         std::back_inserter(res));
+        layer_tiles(lr_nm)->query(boost::geometry::index::intersects(ext),
+                                  std::back_inserter(res));
         return res;
     }
 
@@ -134,25 +166,63 @@ protected:
         return fetch_or(*cmd, std::string{});
     }
 
-    geometry::box_rtree load_tiles(const qualified_name& col_nm)
+    /// The query runs on its own connection, so the loader outlives the call
+    meta::tile_grid::loader_type make_tiles_loader(
+        const qualified_name& col_nm)
     {
         auto bld = builder(as_mixin());
         as_dialect().extent_sql(bld, col_nm);
+        return [pool = pool_, bld] {
+            auto cmd = pool->make_command();
+            exec(*cmd, bld);
+            auto rows = fetch_all(*cmd);
+            auto row = select(rows).front();
+            auto count = boost::lexical_cast<size_t>(row[0]);
+            auto ext = geometry::box{};
+            if (count) {
+                if (row.size() > 2)
+                    ext = {{boost::lexical_cast<double>(row[1]),
+                            boost::lexical_cast<double>(row[2])},
+                           {boost::lexical_cast<double>(row[3]),
+                            boost::lexical_cast<double>(row[4])}};
+                else
+                    ext = geometry::envelope(
+                        geometry::poly_from_wkb(std::get<blob_view>(row[1])));
+            }
+            return make_tiles(count, ext);
+        };
+    }
+
+    /// One round trip for all columns instead of two scans per column
+    geometry_columns_ptr load_geometry_columns()
+    try {
+        enum columns { Schema, Table, Column, Srid, Count, Extent };
+        auto bld = builder(as_mixin());
+        if (!as_dialect().geometry_columns_sql(bld))
+            return nullptr;
         auto rows = fetch_all(as_mixin(), bld);
-        auto row = select(rows).front();
-        auto count = boost::lexical_cast<size_t>(row[0]);
-        auto ext = geometry::box{};
-        if (count) {
-            if (row.size() > 2)
-                ext = {{boost::lexical_cast<double>(row[1]),
-                        boost::lexical_cast<double>(row[2])},
-                       {boost::lexical_cast<double>(row[3]),
-                        boost::lexical_cast<double>(row[4])}};
-            else
-                ext = geometry::envelope(
-                    geometry::poly_from_wkb(std::get<blob_view>(row[1])));
+        auto res = std::make_shared<
+            std::map<qualified_name, geometry_column_info>>();
+        for (auto& row : select(rows)) {
+            auto& info =
+                (*res)[id(boost::lexical_cast<std::string>(row[Schema]),
+                          boost::lexical_cast<std::string>(row[Table]),
+                          boost::lexical_cast<std::string>(row[Column]))];
+            if (!is_null(row[Srid]))
+                info.srid = boost::lexical_cast<int>(row[Srid]);
+            if (!is_null(row[Count]) && !is_null(row[Extent]))
+                info.tiles = make_tiles(
+                    boost::lexical_cast<size_t>(row[Count]),
+                    geometry::envelope(geometry::geom_from_wkb(
+                        std::get<blob_view>(row[Extent]))));
         }
-        return make_tiles(count, ext);
+        return res;
+    }
+    catch (const busy_exception&) {
+        throw;
+    }
+    catch (const std::exception&) {
+        return nullptr;
     }
 
     void prepare_geometry_column(const qualified_name& tbl_nm,
@@ -160,16 +230,40 @@ protected:
                                  std::string_view type)
     {
         auto col_nm = id(tbl_nm, col.name);
-        auto srid = as_mixin().load_projection(col_nm);
+        auto info = find_geometry_column(col_nm);
+        auto srid = info ? info->srid : as_mixin().load_projection(col_nm);
         col.projection = as_mixin().find_proj(srid);
         col.decoder = as_dialect().geom_decoder();
         col.encoder = as_dialect().geom_encoder(type, srid);
-        col.tiles = as_mixin().load_tiles(col_nm);
+        col.tiles = meta::tile_grid{as_mixin().make_tiles_loader(col_nm),
+                                    info ? info->tiles : std::nullopt};
     }
 
 private:
     std::shared_ptr<pool> pool_;
     dialect_holder dialect_;
+
+    /// The layer is displayed, so its exact grid is computed in the
+    /// background. Tables that are only described, e.g. after DDL or
+    /// copying, are never scanned.
+    meta::tile_grid::value_type layer_tiles(const qualified_name& lr_nm)
+    {
+        return column(*this, lr_nm).tiles.get(
+            [](auto task) { background_executor().submit(std::move(task)); });
+    }
+
+    std::optional<geometry_column_info> find_geometry_column(
+        const qualified_name& col_nm)
+    try {
+        auto infos = as_mixin().cached_geometry_columns();
+        if (infos)
+            if (auto it = infos->find(col_nm); it != infos->end())
+                return it->second;
+        return std::nullopt;
+    }
+    catch (const busy_exception&) {
+        return std::nullopt;
+    }
 };
 
 }  // namespace bark::db
@@ -4,6 +4,7 @@
 #define BARK_DB_SQLITE_DIALECT_HPP
 
 #include <bark/db/detail/dialect.hpp>
+#include <bark/db/detail/meta_ops.hpp>
 #include <bark/db/detail/utility.hpp>
 #include <bark/geometry/as_binary.hpp>
 #include <bark/geometry/geometry_ops.hpp>
@@ -11,6 +12,28 @@
 namespace bark::db {
 
 struct sqlite_dialect : dialect {
+    /// Part of the layer extent above which a scan beats the R-tree
+    static constexpr double ScanSelectivity = .25;
+
+    /// Rows of an unindexed layer that make a spatial index worthwhile
+    static constexpr size_t IndexRows = 10 * RowsPerTile;
+
+    /// Estimated part of the rows within the extent
+    static double selectivity(const column_statistics& stats,
+                              const geometry::box& ext)
+    {
+        using namespace boost::geometry;
+        if (!stats.rows)
+            return 0;
+        auto total = area(stats.extent);
+        if (!(total > 0))
+            return intersects(stats.extent, ext) ? 1 : 0;
+        geometry::box common;
+        if (!intersection(stats.extent, ext, common))
+            return 0;
+        return area(common) / total;
+    }
+
     void projections_sql(sql_builder& bld) override
     {
         ogc_projections_sql(bld);
@@ -96,6 +119,20 @@ ORDER BY is_primary DESC, index_name, seqno
 )";
     }
 
+    /// Spatialite statistics, they may be missing or out of date
+    bool geometry_columns_sql(sql_builder& bld) override
+    {
+        bld << "SELECT NULL, t.name, g.f_geometry_column, g.srid, "
+               "s.row_count, ST_AsBinary(BuildMbr(s.extent_min_x, "
+               "s.extent_min_y, s.extent_max_x, s.extent_max_y)) FROM "
+               "geometry_columns g JOIN sqlite_master t ON "
+               "LOWER(g.f_table_name) = LOWER(t.name) LEFT JOIN "
+               "geometry_columns_statistics s ON LOWER(s.f_table_name) = "
+               "LOWER(g.f_table_name) AND LOWER(s.f_geometry_column) = "
+               "LOWER(g.f_geometry_column)";
+        return true;
+    }
+
     sql_decoder geom_decoder() override { return st_as_binary(); }
 
     sql_encoder geom_encoder(std::string_view, int srid) override
@@ -109,6 +146,9 @@ ORDER BY is_primary DESC, index_name, seqno
             << ")) FROM " << qualifier(col_nm);
     }
 
+    /// Chooses a plan by the layer statistics. The R-tree lookup pays for
+    /// itself only on a small part of the layer, otherwise the table is
+    /// scanned. Unknown statistics favor the R-tree.
     void window_clause(sql_builder& bld,
                        const meta::table& tbl,
                        std::string_view col_nm,
@@ -116,7 +156,9 @@ ORDER BY is_primary DESC, index_name, seqno
     {
         using namespace geometry;
         auto cols = {col_nm};
-        if (indexed(tbl.indexes, cols))
+        auto stats = statistics(tbl, col_nm);
+        if (indexed(tbl.indexes, cols) &&
+            (!stats || selectivity(*stats, ext) < ScanSelectivity))
             bld << "rowid IN (SELECT pkid FROM "
                 << index_name(tbl.name.back(), cols)
                 << " WHERE xmax >= " << param{left(ext)}
@@ -165,6 +207,16 @@ ORDER BY is_primary DESC, index_name, seqno
             << ")";
     }
 
+    void drop_spatial_index_sql(sql_builder& bld,
+                                const qualified_name& col_nm,
+                                const qualified_name& idx_nm) override
+    {
+        auto& col = col_nm.back();
+        auto& tbl = col_nm.at(-2);
+        bld << "SELECT DisableSpatialIndex(" << param{tbl} << ", "
+            << param{col} << ");\nDROP TABLE " << idx_nm;
+    }
+
     void page_clause(sql_builder& bld, size_t offset, size_t limit) override
     {
         limit_page_clause(bld, offset, limit);
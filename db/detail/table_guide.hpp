@@ -3,9 +3,14 @@
 #ifndef BARK_DB_TABLE_GUIDE_HPP
 #define BARK_DB_TABLE_GUIDE_HPP
 
+#include <algorithm>
+#include <bark/detail/unicode.hpp>
 #include <boost/lexical_cast.hpp>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 namespace bark::db {
 
@@ -19,16 +24,137 @@ class table_guide {
     T& as_mixin() { return static_cast<T&>(*this); }
 
 protected:
+    using rows_type = std::vector<std::vector<variant_t>>;
+
+    using rows_map = std::map<qualified_name, rows_type>;
+
+    /// Description of the directory tables by batched catalog queries.
+
+    /// The rows refer to the rowsets. Tables are keyed in lower case.
+    struct catalog {
+        std::vector<rowset> rowsets;
+        rows_map columns_by_table;
+        rows_map indexes_by_table;
+    };
+
+    using catalog_ptr = std::shared_ptr<const catalog>;
+
     meta::table load_table(const qualified_name& tbl_nm)
     {
         meta::table res;
         res.name = tbl_nm;
-        load_columns(res);
-        load_indexes(res);
+        if (auto ctlg = find_catalog()) {
+            auto key = lower_case(tbl_nm);
+            auto cols = ctlg->columns_by_table.find(key);
+            if (cols != ctlg->columns_by_table.end()) {
+                load_columns(res, cols->second);
+                auto idxs = ctlg->indexes_by_table.find(key);
+                if (idxs != ctlg->indexes_by_table.end())
+                    load_indexes(res, idxs->second);
+                return res;
+            }
+        }
+        auto& dial = as_mixin().as_dialect();
+        auto cols_bld = builder(as_mixin());
+        dial.columns_sql(cols_bld, tbl_nm);
+        auto cols = fetch_all(as_mixin(), cols_bld);
+        load_columns(res, select(cols));
+        auto idxs_bld = builder(as_mixin());
+        dial.indexes_sql(idxs_bld, tbl_nm);
+        auto idxs = fetch_all(as_mixin(), idxs_bld);
+        load_indexes(res, select(idxs));
         return res;
     }
 
+    /// Two round trips per BatchTables tables instead of two per table
+    catalog_ptr load_catalog()
+    try {
+        auto tbl_nms = std::vector<qualified_name>{};
+        for (auto& [lr_nm, type] : as_mixin().cached_dir())
+            tbl_nms.push_back(qualifier(lr_nm));
+        tbl_nms.erase(std::unique(tbl_nms.begin(), tbl_nms.end()),
+                      tbl_nms.end());
+        if (tbl_nms.empty())
+            return nullptr;
+        auto& dial = as_mixin().as_dialect();
+        auto res = std::make_shared<catalog>();
+        auto cols_spellings = spellings{};
+        auto idxs_spellings = spellings{};
+        for (size_t first = 0; first < tbl_nms.size(); first += BatchTables) {
+            auto last = std::min(tbl_nms.size(), first + BatchTables);
+            auto batch = std::vector<qualified_name>(
+                tbl_nms.begin() + first, tbl_nms.begin() + last);
+            auto cols_bld = builder(as_mixin());
+            auto idxs_bld = builder(as_mixin());
+            if (!dial.batch_columns_sql(cols_bld, batch) ||
+                !dial.batch_indexes_sql(idxs_bld, batch))
+                return nullptr;
+            res->rowsets.push_back(fetch_all(as_mixin(), cols_bld));
+            group(res->rowsets.back(), res->columns_by_table, cols_spellings);
+            res->rowsets.push_back(fetch_all(as_mixin(), idxs_bld));
+            group(res->rowsets.back(), res->indexes_by_table, idxs_spellings);
+        }
+        drop_ambiguous(res->columns_by_table, cols_spellings);
+        drop_ambiguous(res->indexes_by_table, idxs_spellings);
+        return res;
+    }
+    catch (const busy_exception&) {
+        throw;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "catalog queries failed, tables are described one by "
+                     "one: "
+                  << e.what() << std::endl;
+        return nullptr;
+    }
+
 private:
+    catalog_ptr find_catalog()
+    try {
+        return as_mixin().cached_catalog();
+    }
+    catch (const busy_exception&) {
+        return nullptr;
+    }
+
+    /// Keeps the row value predicate IN of a catalog query short
+    static constexpr size_t BatchTables = 500;
+
+    /// The original name of a lower case key, empty if there are several
+    using spellings = std::map<qualified_name, qualified_name>;
+
+    /// Lower case, like the LOWER() comparisons of the per-table queries
+    static qualified_name lower_case(const qualified_name& name)
+    {
+        auto res = qualified_name{};
+        for (auto& part : name)
+            res.push_back(unicode::to_lower(part));
+        return res;
+    }
+
+    /// Splits rows by the leading TABLE_SCHEMA, TABLE_NAME
+    static void group(const rowset& rows, rows_map& res, spellings& spells)
+    {
+        enum columns { Schema, Table, Rest };
+        for (auto& row : select(rows)) {
+            auto tbl_nm = id(boost::lexical_cast<std::string>(row[Schema]),
+                             boost::lexical_cast<std::string>(row[Table]));
+            auto key = lower_case(tbl_nm);
+            if (auto it = spells.emplace(key, tbl_nm).first;
+                it->second != tbl_nm)
+                it->second.clear();
+            res[key].emplace_back(row.begin() + Rest, row.end());
+        }
+    }
+
+    /// Tables that differ only in case are described one by one
+    static void drop_ambiguous(rows_map& rows, const spellings& spells)
+    {
+        for (auto& [key, tbl_nm] : spells)
+            if (tbl_nm.empty())
+                rows.erase(key);
+    }
+
     meta::column make_column(const qualified_name& tbl_nm,
                              std::string_view name,
                              std::string_view type,
@@ -49,13 +175,10 @@ private:
         return res;
     }
 
-    void load_columns(meta::table& tbl)
+    void load_columns(meta::table& tbl, const rows_type& rows)
     {
         enum columns { Name, Type, Scale };
-        auto bld = builder(as_mixin());
-        as_mixin().as_dialect().columns_sql(bld, tbl.name);
-        auto rows = fetch_all(as_mixin(), bld);
-        for (auto& row : select(rows)) {
+        for (auto& row : rows) {
             auto name = boost::lexical_cast<std::string>(row[Name]);
             auto type = boost::lexical_cast<std::string>(row[Type]);
             auto scale =
@@ -71,15 +194,12 @@ private:
             throw std::runtime_error(concat("no columns: ", tbl.name));
     }
 
-    void load_indexes(meta::table& tbl)
+    void load_indexes(meta::table& tbl, const rows_type& rows)
     {
         enum columns { Schema, Name, Column, Primary, Descending };
         auto idx_nm = qualified_name{};
         auto idx = meta::index{};
-        auto bld = builder(as_mixin());
-        as_mixin().as_dialect().indexes_sql(bld, tbl.name);
-        auto rows = fetch_all(as_mixin(), bld);
-        for (auto& row : select(rows)) {
+        for (auto& row : rows) {
             auto name = id(boost::lexical_cast<std::string>(row[Schema]),
                            boost::lexical_cast<std::string>(row[Name]));
             if (name != idx_nm) {
@@ -90,6 +210,7 @@ private:
                 idx = meta::index();
                 idx.type = test(row[Primary]) ? meta::index_type::Primary
                                               : meta::index_type::Secondary;
+                idx.name = name;
             }
 
             auto col = boost::lexical_cast<std::string>(row[Column]);
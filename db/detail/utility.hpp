@@ -7,6 +7,7 @@
 #include <bark/db/sql_builder.hpp>
 #include <bark/geometry/as_binary.hpp>
 #include <initializer_list>
+#include <vector>
 
 namespace bark::db {
 
@@ -81,6 +82,25 @@ inline void iso_layers_sql(sql_builder& bld,
         << list{types, ",", [](auto type) { return param{type}; }} << ")";
 }
 
+/// "(schema, table), ..." for the row value predicate IN
+inline void schema_table_list(sql_builder& bld,
+                              const std::vector<qualified_name>& tbl_nms)
+{
+    for (size_t i = 0; i < tbl_nms.size(); ++i)
+        bld << (i ? ", (" : "(") << param{tbl_nms[i].at(-2)} << ", "
+            << param{tbl_nms[i].back()} << ")";
+}
+
+inline void iso_batch_columns_sql(sql_builder& bld,
+                                  const std::vector<qualified_name>& tbl_nms)
+{
+    bld << "SELECT table_schema, table_name, column_name, LOWER(data_type), "
+           "numeric_scale FROM information_schema.columns WHERE "
+           "(table_schema, table_name) IN (";
+    schema_table_list(bld, tbl_nms);
+    bld << ") ORDER BY table_schema, table_name, ordinal_position";
+}
+
 inline void iso_columns_sql(sql_builder& bld, const qualified_name& tbl_nm)
 {
     auto& tbl = tbl_nm.back();
@@ -3,25 +3,49 @@
 #ifndef BARK_DB_GDAL_COMMAND_HPP
 #define BARK_DB_GDAL_COMMAND_HPP
 
+#include <algorithm>
 #include <bark/db/command.hpp>
 #include <bark/db/detail/meta_ops.hpp>
-#include <bark/db/detail/transaction.hpp>
 #include <bark/db/gdal/detail/bind_column.hpp>
 #include <bark/db/gdal/detail/dataset.hpp>
 #include <bark/db/gdal/detail/layer.hpp>
+#include <bark/db/gdal/detail/statement.hpp>
 #include <bark/geometry/geometry_ops.hpp>
+#include <boost/algorithm/string.hpp>
+#include <charconv>
 #include <iterator>
 #include <mutex>
+#include <optional>
 #include <stdexcept>
 
 namespace bark::db::gdal {
 
-class command : public db::command, private transaction<gdal::command> {
-    friend transaction<gdal::command>;
-
+/// GDAL has no parameter binding. Insertions are written feature by feature
+/// via OGR API, so geometries are passed as WKB without hex encoding. In
+/// other statements the parameters are embedded. Scripts of
+/// gdal::provider::ddl create layers via OGR API too.
+class command : public db::command {
 public:
-    explicit command(const std::string& file) : ds_{file}, lr_(nullptr, nullptr)
+    explicit command(const std::string& file)
+        : file_{file}, ds_{file}, lr_(nullptr, nullptr)
+    {
+    }
+
+    /// Takes a dataset made by dataset::create
+    command(const std::string& file, dataset ds)
+        : file_{file}, ds_{std::move(ds)}, lr_(nullptr, nullptr)
+    {
+        updatable_ = true;
+    }
+
+    ~command() override
     {
+        try {
+            rollback();
+        }
+        catch (...) {
+            // destructors must not throw
+        }
     }
 
     sql_quoted_identifier quoted_identifier() override
@@ -29,18 +53,41 @@ public:
         return [](auto id) { return concat('"', id, '"'); };
     }
 
-    sql_parameter_marker parameter_marker() override { return nullptr; }
+    sql_parameter_marker parameter_marker() override
+    {
+        return [](auto) { return "?"; };
+    }
 
     void exec(const sql_builder& bld) override
     {
-        if (!bld.params().empty())
-            throw std::logic_error{"not implemented"};
-        reset_lr(ds_.layer_by_sql(bld.sql()));
+        auto& params = bld.params();
+        if (auto ins = parse_insertion(bld.sql(), params.size()))
+            return insert(*ins, params);
+        auto sql =
+            params.empty() ? std::string{bld.sql()} : embed(bld.sql(), params);
+        auto stmts = split(sql);
+        if (stmts.size() > 1) {
+            for (auto stmt : stmts)
+                db::exec(*this, stmt);
+        }
+        else if (auto def = parse_create_table(sql))
+            create_table(*def);
+        else if (auto idx = parse_spatial_index(sql))
+            create_spatial_index(*idx);
+        else if (auto idx = parse_drop_spatial_index(sql))
+            drop_spatial_index(*idx);
+        else {
+            if (!read_only(sql))
+                updatable();
+            execute(sql, "SQLITE");
+        }
     }
 
     std::vector<std::string> columns() override
     {
         reset_cols();
+        if (!lr_)
+            return {};
         auto feat_def = OGR_L_GetLayerDefn(lr_);
         for (int i = 0; i < OGR_FD_GetGeomFieldCount(feat_def); ++i)
             geoms_.push_back(std::make_unique<column_geom>());
@@ -74,10 +121,20 @@ public:
 
     void set_autocommit(bool autocommit) override
     {
-        transaction::set_autocommit(autocommit);
+        if (autocommit_ != autocommit) {
+            autocommit_ = autocommit;
+            if (autocommit)
+                rollback();
+        }
     }
 
-    void commit() override { transaction::commit(); }
+    void commit() override
+    {
+        if (transaction_) {
+            transaction_ = false;
+            check(GDALDatasetCommitTransaction(ds_));
+        }
+    }
 
     void open(const qualified_name& layer, const geometry::box& bbox)
     {
@@ -90,10 +147,19 @@ public:
     }
 
 private:
+    struct field {
+        enum { Geometry, Fid, Attribute } kind;
+        int idx;
+    };
+
+    std::string file_;
     dataset ds_;
     layer lr_;
     std::vector<column_holder> geoms_;
     std::vector<column_holder> cols_;
+    bool updatable_ = false;
+    bool autocommit_ = true;
+    bool transaction_ = false;
 
     void reset_cols()
     {
@@ -107,8 +173,272 @@ private:
         lr_ = std::move(lr);
         check(!!lr_);
     }
+
+    void close()
+    {
+        reset_cols();
+        lr_ = layer{nullptr, nullptr};
+    }
+
+    /// Reopens the dataset for writing and begins a transaction if needed
+    void updatable()
+    {
+        if (!updatable_) {
+            close();
+            ds_ = dataset{file_, GDAL_OF_UPDATE | GDAL_OF_VECTOR};
+            updatable_ = true;
+        }
+        if (!autocommit_ && !transaction_)
+            transaction_ =  // not all drivers support it
+                OGRERR_NONE == GDALDatasetStartTransaction(ds_, false);
+    }
+
+    void execute(const std::string& sql, const char* dialect)
+    {
+        close();
+        CPLErrorReset();
+        lr_ = ds_.layer_by_sql(sql, dialect);
+        check(!!lr_ || CPLGetLastErrorType() < CE_Failure);
+    }
+
+    void rollback()
+    {
+        if (transaction_) {
+            transaction_ = false;
+            check(GDALDatasetRollbackTransaction(ds_));
+        }
+    }
+
+    /// Drivers that can build a spatial index on existing features
+    bool deferrable_spatial_index() const
+    {
+        auto drv = ds_.driver();
+        return drv == "GPKG" || drv == "SQLite" || drv == "ESRI Shapefile";
+    }
+
+    /// Drivers that name the FID column by the layer creation option.
+    /// Others, like Shapefile or FlatGeobuf, ignore it.
+    bool named_fid() const
+    {
+        auto drv = ds_.driver();
+        return drv == "GPKG" || drv == "SQLite";
+    }
+
+    /// Creates a layer via OGR API. The spatial index is created later by
+    /// @ref create_spatial_index if the driver supports this.
+    void create_table(const table_definition& def)
+    {
+        updatable();
+        close();
+        std::vector<std::pair<std::string, int>> geoms;  ///< name, SRID
+        std::vector<std::pair<std::string, OGRFieldType>> attrs;
+        std::string fid;
+        for (auto& [name, type] : def.columns) {
+            if (auto srid = geometry_srid(type))
+                geoms.emplace_back(name, *srid);
+            else if (named_fid() && def.primary_key == std::vector{name} &&
+                     field_type(type) == OFTInteger64)
+                fid = name;
+            else
+                attrs.emplace_back(name, field_type(type));
+        }
+        std::vector<std::string> opts;
+        if (!geoms.empty())
+            opts.push_back("GEOMETRY_NAME=" + geoms.front().first);
+        if (!fid.empty())
+            opts.push_back("FID=" + fid);
+        if (deferrable_spatial_index())
+            opts.push_back("SPATIAL_INDEX=NO");
+        std::vector<char*> opt_ptrs;
+        for (auto& opt : opts)
+            opt_ptrs.push_back(opt.data());
+        opt_ptrs.push_back(nullptr);
+
+        auto lr = GDALDatasetCreateLayer(
+            ds_,
+            def.table.c_str(),
+            geoms.empty() ? nullptr
+                          : spatial_reference(geoms.front().second).get(),
+            geoms.empty() ? wkbNone : wkbUnknown,
+            opt_ptrs.data());
+        check(!!lr);
+        for (size_t i = 1; i < geoms.size(); ++i) {
+            geometry_field_definition_holder fld_def{
+                OGR_GFld_Create(geoms[i].first.c_str(), wkbUnknown)};
+            OGR_GFld_SetSpatialRef(fld_def.get(),
+                                   spatial_reference(geoms[i].second).get());
+            check(OGR_L_CreateGeomField(lr, fld_def.get(), true));
+        }
+        for (auto& [name, type] : attrs) {
+            field_definition_holder fld_def{
+                OGR_Fld_Create(name.c_str(), type)};
+            check(OGR_L_CreateField(lr, fld_def.get(), true));
+        }
+    }
+
+    /// Other drivers build it at layer creation
+    void create_spatial_index(const spatial_index& idx)
+    {
+        if (!deferrable_spatial_index())
+            return;
+        updatable();
+        auto drv = ds_.driver();
+        sql_builder bld{quoted_identifier(), nullptr};
+        if (drv == "GPKG" || drv == "SQLite")
+            bld << "SELECT CreateSpatialIndex(" << param{idx.table} << ", "
+                << param{idx.column} << ")";
+        else
+            bld << "CREATE SPATIAL INDEX ON " << id(idx.table);
+        execute(std::string{bld.sql()}, nullptr);
+        close();
+    }
+
+    /// Kept by the drivers that can not build it on existing features
+    void drop_spatial_index(const spatial_index& idx)
+    {
+        if (!deferrable_spatial_index())
+            return;
+        updatable();
+        auto drv = ds_.driver();
+        sql_builder bld{quoted_identifier(), nullptr};
+        if (drv == "GPKG" || drv == "SQLite")
+            bld << "SELECT DisableSpatialIndex(" << param{idx.table} << ", "
+                << param{idx.column} << ")";
+        else
+            bld << "DROP SPATIAL INDEX ON " << id(idx.table);
+        execute(std::string{bld.sql()}, nullptr);
+        if (drv == "SQLite") {
+            bld.clear();
+            bld << "DROP TABLE "
+                << id(concat("idx_", idx.table, "_", idx.column));
+            execute(std::string{bld.sql()}, nullptr);
+        }
+        close();
+    }
+
+    /// Returns nothing if the type is not "geometry(SRID)"
+    static std::optional<int> geometry_srid(const std::string& type)
+    {
+        static const std::string Prefix = "geometry";
+        if (!boost::istarts_with(type, Prefix))
+            return std::nullopt;
+        int res = 0;
+        auto first = type.data() + Prefix.size();
+        auto last = type.data() + type.size();
+        if (first != last && *first == '(')
+            std::from_chars(first + 1, last, res);
+        return res;
+    }
+
+    static OGRFieldType field_type(const std::string& type)
+    {
+        if (boost::iequals(type, "integer"))
+            return OFTInteger64;
+        if (boost::iequals(type, "real"))
+            return OFTReal;
+        if (boost::iequals(type, "text"))
+            return OFTString;
+        if (boost::iequals(type, "blob"))
+            return OFTBinary;
+        throw std::runtime_error(concat("unsupported type: ", type));
+    }
+
+    static spatial_reference_holder spatial_reference(int srid)
+    {
+        if (!srid)
+            return spatial_reference_holder{};
+        spatial_reference_holder res{OSRNewSpatialReference(nullptr)};
+        check(OSRImportFromEPSG(res.get(), srid));
+        return res;
+    }
+
+    void insert(const insertion& ins, const std::vector<variant_t>& params)
+    {
+        updatable();
+        close();
+        auto lr = ds_.layer_by_name(id(ins.table));
+        check(!!lr);
+        auto feat_def = OGR_L_GetLayerDefn(lr);
+        std::vector<field> fields;
+        for (auto& col : ins.columns) {
+            auto idx = OGR_FD_GetGeomFieldIndex(feat_def, col.c_str());
+            if (idx < 0 && col == GeometryColumn &&
+                OGR_FD_GetGeomFieldCount(feat_def) > 0)
+                idx = 0;
+            if (idx >= 0)
+                fields.push_back({field::Geometry, idx});
+            else if ((idx = OGR_FD_GetFieldIndex(feat_def, col.c_str())) >= 0)
+                fields.push_back({field::Attribute, idx});
+            else if (col == OGR_L_GetFIDColumn(lr))
+                fields.push_back({field::Fid, -1});
+            else if (unnamed_geometry(feat_def) &&  // Shapefile, FlatGeobuf
+                     std::none_of(fields.begin(), fields.end(), [](auto& f) {
+                         return f.kind == field::Geometry;
+                     }))
+                fields.push_back({field::Geometry, 0});
+            else
+                throw std::runtime_error(concat("no field ", col));
+        }
+        auto param_it = params.begin();
+        for (size_t row = 0; row < ins.rows; ++row) {
+            feature_holder feat{OGR_F_Create(feat_def)};
+            for (auto& fld : fields)
+                set(feat.get(), fld, *param_it++);
+            check(OGR_L_CreateFeature(lr, feat.get()));
+        }
+    }
+
+    static bool unnamed_geometry(OGRFeatureDefnH feat_def)
+    {
+        return OGR_FD_GetGeomFieldCount(feat_def) == 1 &&
+               !*OGR_GFld_GetNameRef(OGR_FD_GetGeomFieldDefn(feat_def, 0));
+    }
+
+    static void set(OGRFeatureH feat, const field& fld, const variant_t& var)
+    {
+        if (std::holds_alternative<std::monostate>(var) &&
+            fld.kind != field::Attribute)
+            return;
+        if (fld.kind == field::Fid) {
+            check(OGR_F_SetFID(feat, std::get<int64_t>(var)));
+            return;
+        }
+        if (fld.kind == field::Geometry) {
+            auto wkb = std::get<blob_view>(var);
+            OGRGeometryH geom = nullptr;
+            check(OGR_G_CreateFromWkb(wkb.data(), nullptr, &geom, wkb.size()));
+            check(OGR_F_SetGeomFieldDirectly(feat, fld.idx, geom));
+            return;
+        }
+        std::visit(
+            overloaded{
+                [&](std::monostate) { OGR_F_SetFieldNull(feat, fld.idx); },
+                [&](int64_t v) { OGR_F_SetFieldInteger64(feat, fld.idx, v); },
+                [&](double v) { OGR_F_SetFieldDouble(feat, fld.idx, v); },
+                [&](std::string_view v) {
+                    // null-terminated by sql_builder
+                    OGR_F_SetFieldString(feat, fld.idx, v.data());
+                },
+                [&](blob_view v) {
+                    OGR_F_SetFieldBinary(feat, fld.idx, v.size(), v.data());
+                }},
+            var);
+    }
 };
 
+/// Creates a vector dataset with the layers of a gdal::provider::ddl script.
+/// Shapefile and FlatGeobuf files can be opened only after this.
+/// @code
+/// auto [tbl_nm, sql] = gdal::provider{"./src.gpkg"}.ddl(tbl);
+/// gdal::create("./new.shp", sql);
+/// auto pvd = gdal::provider{"./new.shp"};
+/// @endcode
+inline void create(const std::string& file, std::string_view ddl)
+{
+    auto cmd = command{file, dataset::create(file)};
+    db::exec(cmd, ddl);
+}
+
 }  // namespace bark::db::gdal
 
 #endif  // BARK_DB_GDAL_COMMAND_HPP
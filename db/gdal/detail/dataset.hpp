@@ -6,23 +6,73 @@
 #include <atomic>
 #include <bark/db/gdal/detail/layer.hpp>
 #include <bark/db/qualified_name.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/range/algorithm/find_if.hpp>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace bark::db::gdal {
 
+inline void register_drivers()
+{
+    static std::once_flag flag;
+    std::call_once(flag, GDALAllRegister);
+}
+
+inline bool exists(const std::string& file)
+{
+    VSIStatBufL stat;
+    return VSIStatL(file.c_str(), &stat) == 0;
+}
+
 class dataset {
 public:
-    explicit dataset(const std::string& file)
+    /// @param flags - GDAL_OF_UPDATE to write, read-only by default
+    explicit dataset(const std::string& file, unsigned flags = 0)
     {
-        static std::once_flag flag;
-        std::call_once(flag, GDALAllRegister);
-        ds_.reset(GDALOpenEx(file.c_str(), 0, nullptr, nullptr, nullptr));
+        register_drivers();
+        ds_.reset(GDALOpenEx(file.c_str(), flags, nullptr, nullptr, nullptr));
         check(!!ds_);
     }
 
+    /// Creates an empty vector dataset, which is writable.
+    /// The driver is chosen by the extension.
+    static dataset create(const std::string& file)
+    {
+        register_drivers();
+        auto ext = file.substr(file.find_last_of("./\\") + 1);
+        for (int i = 0; i < GDALGetDriverCount(); ++i) {
+            auto drv = GDALGetDriver(i);
+            auto exts = GDALGetMetadataItem(drv, GDAL_DMD_EXTENSIONS, nullptr);
+            if (!exts ||
+                !GDALGetMetadataItem(drv, GDAL_DCAP_VECTOR, nullptr) ||
+                !GDALGetMetadataItem(drv, GDAL_DCAP_CREATE, nullptr))
+                continue;
+            std::vector<std::string> items;
+            boost::split(items, exts, boost::is_space());
+            if (boost::range::find_if(items, [&](auto& item) {
+                    return boost::iequals(item, ext);
+                }) == items.end())
+                continue;
+            dataset res;
+            res.ds_.reset(
+                GDALCreate(drv, file.c_str(), 0, 0, 0, GDT_Unknown, nullptr));
+            check(!!res.ds_);
+            return res;
+        }
+        throw std::runtime_error(concat("unsupported file format: ", file));
+    }
+
     operator GDALDatasetH() const { return ds_.get(); }
 
+    std::string driver() const
+    {
+        return GDALGetDescription(GDALGetDatasetDriver(ds_.get()));
+    }
+
     std::string projection() const
     {
         spatial_reference_holder srs{
@@ -72,17 +122,33 @@ public:
                 GDALDatasetGetLayerByName(ds_.get(), tbl.back().c_str())};
     }
 
-    layer layer_by_sql(const std::string& sql) const
+    /// @param dialect - nullptr means the default one of the driver
+    layer layer_by_sql(const std::string& sql,
+                       const char* dialect = "SQLITE") const
     {
         return {
             ds_.get(),
-            GDALDatasetExecuteSQL(ds_.get(), sql.c_str(), nullptr, "SQLITE")};
+            GDALDatasetExecuteSQL(ds_.get(), sql.c_str(), nullptr, dialect)};
     }
 
 private:
     dataset_holder ds_;
+
+    dataset() = default;
 };
 
+/// Creates an empty vector dataset. The driver is chosen by the extension.
+/// Shapefile and FlatGeobuf are not written until they get a layer, use
+/// @ref gdal::create(const std::string&, std::string_view) for them.
+/// @code
+/// gdal::create("./new.gpkg");
+/// auto pvd = gdal::provider{"./new.gpkg"};
+/// @endcode
+inline void create(const std::string& file)
+{
+    dataset::create(file);
+}
+
 }  // namespace bark::db::gdal
 
 #endif  // BARK_DB_GDAL_DATASET_HPP
@@ -0,0 +1,309 @@
+// Andrew Naplavkov
+
+#ifndef BARK_DB_GDAL_STATEMENT_HPP
+#define BARK_DB_GDAL_STATEMENT_HPP
+
+#include <algorithm>
+#include <bark/db/sql_builder.hpp>
+#include <cctype>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bark::db::gdal {
+
+/// Statement "INSERT INTO table (column, ...) VALUES (?, ...), ..."
+struct insertion {
+    std::string table;
+    std::vector<std::string> columns;
+    size_t rows = 0;
+};
+
+/// Statement "CREATE TABLE table (column type, ..., PRIMARY KEY (column))"
+struct table_definition {
+    std::string table;
+    std::vector<std::pair<std::string, std::string>> columns;  ///< name, type
+    std::vector<std::string> primary_key;
+};
+
+/// Statement "CREATE SPATIAL INDEX ON table (column)"
+struct spatial_index {
+    std::string table;
+    std::string column;
+};
+
+namespace detail {
+
+/// Splits SQL text into identifiers, keywords and punctuation
+class lexer {
+public:
+    explicit lexer(std::string_view sql) : sql_{sql} {}
+
+    /// Returns false at the end of the text or on a string literal
+    bool next(std::string& token, bool& quoted)
+    {
+        while (pos_ < sql_.size() && std::isspace((unsigned char)sql_[pos_]))
+            ++pos_;
+        if (pos_ == sql_.size() || sql_[pos_] == '\'')
+            return false;
+        token.clear();
+        quoted = sql_[pos_] == '"';
+        if (quoted) {
+            for (++pos_; pos_ < sql_.size(); ++pos_) {
+                if (sql_[pos_] == '"') {
+                    if (++pos_ == sql_.size() || sql_[pos_] != '"')
+                        return true;  // "" is an escaped quotation mark
+                }
+                token += sql_[pos_];
+            }
+            return false;
+        }
+        if (!word(sql_[pos_])) {
+            token = sql_[pos_++];
+            return true;
+        }
+        while (pos_ < sql_.size() && word(sql_[pos_]))
+            token += sql_[pos_++];
+        return true;
+    }
+
+    static bool word(char c)
+    {
+        return std::isalnum((unsigned char)c) || c == '_';
+    }
+
+private:
+    std::string_view sql_;
+    size_t pos_ = 0;
+};
+
+inline bool iequals(std::string_view lhs, std::string_view rhs)
+{
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+               return std::toupper((unsigned char)a) ==
+                      std::toupper((unsigned char)b);
+           });
+}
+
+class parser {
+public:
+    std::string tok;
+    bool quoted = false;
+    bool end = false;
+
+    explicit parser(std::string_view sql) : lex_{sql} {}
+
+    bool next()
+    {
+        if (lex_.next(tok, quoted))
+            return true;
+        tok.clear();
+        end = true;
+        return false;
+    }
+
+    bool keyword(std::string_view kw)
+    {
+        return next() && !quoted && iequals(tok, kw);
+    }
+
+    bool punct(char c) { return next() && is(c); }
+
+    bool is(char c) const { return !quoted && tok == std::string_view{&c, 1}; }
+
+    /// Reads the last part of a qualified name, GDAL layers are not qualified
+    bool table_name(std::string& res)
+    {
+        if (!next())
+            return false;
+        res = tok;
+        while (punct('.')) {
+            if (!next())
+                return false;
+            res = tok;
+        }
+        return true;
+    }
+
+    /// Reads "(name, ...)" starting from the current token
+    bool names(std::vector<std::string>& res)
+    {
+        if (!is('('))
+            return false;
+        do {
+            if (!next())
+                return false;
+            res.push_back(tok);
+        } while (punct(','));
+        return is(')');
+    }
+
+private:
+    lexer lex_;
+};
+
+}  // namespace detail
+
+/// Recognizes the output of db::insert_sql with parameter markers "?".
+
+/// @return nothing if the statement is something else
+inline std::optional<insertion> parse_insertion(std::string_view sql,
+                                                size_t params)
+{
+    detail::parser prs{sql};
+    insertion res;
+    if (!prs.keyword("INSERT") || !prs.keyword("INTO") ||
+        !prs.table_name(res.table) || !prs.names(res.columns) ||
+        !prs.keyword("VALUES"))
+        return std::nullopt;
+    do {
+        if (!prs.punct('('))
+            return std::nullopt;
+        for (size_t i = 0; i < res.columns.size(); ++i)
+            if ((i && !prs.punct(',')) || !prs.punct('?'))
+                return std::nullopt;
+        if (!prs.punct(')'))
+            return std::nullopt;
+        ++res.rows;
+    } while (prs.punct(','));
+    if (!prs.end || res.rows * res.columns.size() != params)
+        return std::nullopt;
+    return res;
+}
+
+/// Recognizes the output of gdal::provider::ddl
+inline std::optional<table_definition> parse_create_table(std::string_view sql)
+{
+    detail::parser prs{sql};
+    table_definition res;
+    if (!prs.keyword("CREATE") || !prs.keyword("TABLE") ||
+        !prs.table_name(res.table) || !prs.is('('))
+        return std::nullopt;
+    do {
+        if (!prs.next())
+            return std::nullopt;
+        if (!prs.quoted && detail::iequals(prs.tok, "PRIMARY")) {
+            if (!prs.keyword("KEY") || !prs.next() ||
+                !prs.names(res.primary_key))
+                return std::nullopt;
+            prs.next();
+            continue;
+        }
+        auto& [name, type] = res.columns.emplace_back(prs.tok, "");
+        int depth = 0;
+        while (prs.next() && (depth || !(prs.is(',') || prs.is(')')))) {
+            depth += prs.is('(') - prs.is(')');
+            if (!type.empty() && detail::lexer::word(type.back()) &&
+                detail::lexer::word(prs.tok.front()))
+                type += ' ';
+            type += prs.tok;
+        }
+        if (name.empty() || type.empty())
+            return std::nullopt;
+    } while (prs.is(','));
+    if (!prs.is(')') || prs.next())
+        return std::nullopt;
+    return res;
+}
+
+/// Recognizes the output of gdal::provider::ddl
+inline std::optional<spatial_index> parse_spatial_index(std::string_view sql)
+{
+    detail::parser prs{sql};
+    spatial_index res;
+    std::vector<std::string> cols;
+    if (!prs.keyword("CREATE") || !prs.keyword("SPATIAL") ||
+        !prs.keyword("INDEX") || !prs.keyword("ON") ||
+        !prs.table_name(res.table) || !prs.names(cols) || cols.size() != 1 ||
+        prs.next())
+        return std::nullopt;
+    res.column = cols.front();
+    return res;
+}
+
+/// Recognizes the output of gdal::provider::index_ddl
+inline std::optional<spatial_index> parse_drop_spatial_index(
+    std::string_view sql)
+{
+    detail::parser prs{sql};
+    spatial_index res;
+    std::vector<std::string> cols;
+    if (!prs.keyword("DROP") || !prs.keyword("SPATIAL") ||
+        !prs.keyword("INDEX") || !prs.keyword("ON") ||
+        !prs.table_name(res.table) || !prs.names(cols) || cols.size() != 1 ||
+        prs.next())
+        return std::nullopt;
+    res.column = cols.front();
+    return res;
+}
+
+/// Returns true for queries that do not modify a dataset
+inline bool read_only(std::string_view sql)
+{
+    detail::parser prs{sql};
+    return prs.next() && !prs.quoted &&
+           (detail::iequals(prs.tok, "SELECT") ||
+            detail::iequals(prs.tok, "WITH") ||
+            detail::iequals(prs.tok, "EXPLAIN"));
+}
+
+/// Calls the functor with positions of characters outside quotation marks
+template <class Functor>
+void for_each_unquoted(std::string_view sql, Functor f)
+{
+    char quote = 0;
+    for (size_t i = 0; i < sql.size(); ++i) {
+        auto c = sql[i];
+        if (quote) {
+            if (c == quote)
+                quote = 0;
+        }
+        else if (c == '\'' || c == '"')
+            quote = c;
+        else
+            f(i);
+    }
+}
+
+/// Splits the script by semicolons, skips blank statements
+inline std::vector<std::string_view> split(std::string_view script)
+{
+    std::vector<std::string_view> res;
+    size_t first = 0;
+    auto push = [&](size_t last) {
+        auto stmt = script.substr(first, last - first);
+        if (detail::parser{stmt}.next())
+            res.push_back(stmt);
+        first = last + 1;
+    };
+    for_each_unquoted(script, [&](size_t i) {
+        if (script[i] == ';')
+            push(i);
+    });
+    push(script.size());
+    return res;
+}
+
+/// Substitutes literals for the parameter markers "?"
+inline std::string embed(std::string_view sql,
+                         const std::vector<variant_t>& params)
+{
+    sql_builder bld{nullptr, nullptr};
+    auto param_it = params.begin();
+    size_t first = 0;
+    for_each_unquoted(sql, [&](size_t i) {
+        if (sql[i] == '?' && param_it != params.end()) {
+            bld << sql.substr(first, i - first) << param{*param_it++};
+            first = i + 1;
+        }
+    });
+    bld << sql.substr(first);
+    return std::string{bld.sql()};
+}
+
+}  // namespace bark::db::gdal
+
+#endif  // BARK_DB_GDAL_STATEMENT_HPP
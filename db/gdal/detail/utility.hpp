@@ -49,6 +49,22 @@ struct feature_deleter {
 
 using feature_holder = std::unique_ptr<void, feature_deleter>;
 
+/// OGRFieldDefnH
+struct field_definition_deleter {
+    void operator()(void* p) const { OGR_Fld_Destroy(p); }
+};
+
+using field_definition_holder =
+    std::unique_ptr<void, field_definition_deleter>;
+
+/// OGRGeomFieldDefnH
+struct geometry_field_definition_deleter {
+    void operator()(void* p) const { OGR_GFld_Destroy(p); }
+};
+
+using geometry_field_definition_holder =
+    std::unique_ptr<void, geometry_field_definition_deleter>;
+
 /// OGRSpatialReferenceH
 struct spatial_reference_deleter {
     void operator()(void* p) const { OSRDestroySpatialReference(p); };
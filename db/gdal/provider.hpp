@@ -11,6 +11,7 @@
 #include <bark/geometry/as_binary.hpp>
 #include <bark/geometry/envelope.hpp>
 #include <bark/geometry/geometry_ops.hpp>
+#include <bark/proj/epsg.hpp>
 #include <iterator>
 #include <optional>
 #include <stdexcept>
@@ -21,6 +22,7 @@ class provider : private cacher<provider>, public db::provider {
     friend cacher<provider>;
 
 public:
+    /// Opens an existing dataset, see @ref gdal::create for a new one
     explicit provider(std::string_view file) : file_{file}
     {
         if (is_raster())
@@ -42,8 +44,7 @@ public:
     {
         if (is_raster())
             return ref_->extent();
-        auto tls = db::column(*this, lr_nm).tiles;
-        return tls.empty() ? geometry::box{} : geometry::envelope(bounds(tls));
+        return geometry::envelope(*db::column(*this, lr_nm).tiles.get());
     }
 
     geometry::box undistorted_pixel(const qualified_name&,
@@ -63,7 +64,15 @@ public:
                            const geometry::box& ext,
                            const geometry::box& px) override
     {
-        return cached_spatial_objects(lr_nm, ext, px);
+        return is_raster() ? cached_spatial_objects(lr_nm, ext, px)
+                           : cached_vector_objects(lr_nm, ext, px);
+    }
+
+    rowset pick(const qualified_name& lr_nm,
+                const geometry::box& ext,
+                const geometry::box& px) override
+    {
+        return cached_pick(lr_nm, ext, px, !is_raster());
     }
 
     command_holder make_command() override
@@ -79,9 +88,46 @@ public:
         return cached_table(tbl_nm);
     }
 
-    std::pair<qualified_name, std::string> ddl(const meta::table&) override
+    /// Script is executed by gdal::command via OGR API
+    std::pair<qualified_name, std::string> ddl(const meta::table& tbl) override
     {
-        throw std::logic_error{"not implemented"};
+        auto tbl_nm = id(tbl.name.back());
+        auto bld = builder(*this);
+        bld << "CREATE TABLE " << tbl_nm << " (";
+        auto sep = "\n\t";
+        for (auto& col : tbl.columns) {
+            bld << sep << id(col.name) << " " << type_name(col);
+            sep = ",\n\t";
+        }
+        auto pri =
+            boost::range::find_if(tbl.indexes, same{meta::index_type::Primary});
+        if (pri != tbl.indexes.end())
+            bld << ",\n\tPRIMARY KEY (" << list{pri->columns, ", ", id<>}
+                << ")";
+        bld << "\n);\n";
+        for (auto& idx : tbl.indexes)
+            if (idx.type == meta::index_type::Secondary &&
+                db::find(tbl.columns, idx.columns.front())->type ==
+                    meta::column_type::Geometry)
+                bld << "CREATE SPATIAL INDEX ON " << tbl_nm << " ("
+                    << id(idx.columns.front()) << ");\n";
+        return {tbl_nm, std::string{bld.sql()}};
+    }
+
+    /// Spatial indexes only, other ones are not created by @ref ddl
+    std::pair<std::string, std::string> index_ddl(
+        const meta::table& tbl,
+        const meta::index& idx) override
+    {
+        if (idx.type != meta::index_type::Secondary ||
+            db::find(tbl.columns, idx.columns.front())->type !=
+                meta::column_type::Geometry)
+            return {};
+        auto on = builder(*this);
+        on << " SPATIAL INDEX ON " << id(tbl.name.back()) << " ("
+           << id(idx.columns.front()) << ");\n";
+        auto sql = std::string{on.sql()};
+        return {"DROP" + sql, "CREATE" + sql};
     }
 
     void page_clause(sql_builder& bld, size_t offset, size_t limit) override
@@ -105,6 +151,28 @@ private:
         return res;
     }
 
+    static std::string type_name(const meta::column& col)
+    {
+        switch (col.type) {
+            case meta::column_type::Blob:
+                return "blob";
+            case meta::column_type::Geometry:
+                try {
+                    auto srid = proj::epsg().find_srid(col.projection);
+                    return concat("geometry(", srid, ")");
+                }
+                catch (const std::exception&) {
+                    return "geometry";  // without a spatial reference
+                }
+            case meta::column_type::Integer:
+                return "integer";
+            case meta::column_type::Real:
+                return "real";
+            default:
+                return "text";
+        }
+    }
+
     bool is_raster()
     {
         auto reg = dir();
@@ -116,7 +184,7 @@ private:
     {
         auto bld = builder(*this);
         bld << "SELECT * FROM " << tbl_nm << " LIMIT 0";
-        auto qry = dataset{file_}.layer_by_sql(bld.sql()).table();
+        auto qry = dataset{file_}.layer_by_sql(std::string{bld.sql()}).table();
         auto tbl = dataset{file_}.layer_by_name(tbl_nm).table();
         auto diff =
             qry.columns | boost::adaptors::filtered([&](auto& col) {
@@ -144,8 +212,9 @@ private:
         }
         else
             db::column(*this, lr_nm)
-                .tiles.query(boost::geometry::index::intersects(ext),
-                             std::back_inserter(res));
+                .tiles.get()
+                ->query(boost::geometry::index::intersects(ext),
+                        std::back_inserter(res));
         return res;
     }
 
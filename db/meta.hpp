@@ -6,9 +6,15 @@
 #include <bark/db/sql_builder.hpp>
 #include <bark/geometry/geometry.hpp>
 #include <bark/proj/epsg.hpp>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace bark::db::meta {
@@ -19,12 +25,142 @@ enum class index_type { Invalid, Primary, Secondary };
 
 enum class layer_type { Invalid, Geometry, Raster };
 
+/// Balanced data grid that may be computed in the background.
+
+/// It starts from an estimate, if any, and is replaced by the exact grid.
+/// The estimate may be stale, so it answers only until the exact grid is
+/// ready. The loader runs by a scheduled task or by the first caller who
+/// needs the exact grid, whichever comes first, and again on the next call
+/// if it fails. Nothing is scheduled until the grid is asked for. Copies
+/// share the state.
+class tile_grid {
+public:
+    using value_type = std::shared_ptr<const geometry::box_rtree>;
+    using loader_type = std::function<geometry::box_rtree()>;
+
+    tile_grid() : tile_grid(geometry::box_rtree()) {}
+
+    tile_grid(geometry::box_rtree exact) : state_{std::make_shared<state>()}
+    {
+        state_->val = std::make_shared<geometry::box_rtree>(std::move(exact));
+        state_->ready = true;
+    }
+
+    tile_grid(loader_type load, std::optional<geometry::box_rtree> estimate)
+        : state_{std::make_shared<state>()}
+    {
+        state_->load = std::move(load);
+        if (estimate)
+            state_->val =
+                std::make_shared<geometry::box_rtree>(std::move(*estimate));
+    }
+
+    /// Exact grid or estimate, nullptr if there is none yet. Never blocks
+    value_type current() const
+    {
+        auto lock = std::lock_guard{state_->guard};
+        return state_->val;
+    }
+
+    /// Exact grid, or the estimate while @p schedule computes the exact one.
+
+    /// The task is passed to @p schedule once, or again if it fails.
+    /// Blocks only if there is no estimate.
+    template <class Schedule>
+    value_type get(Schedule schedule) const
+    {
+        value_type estimate;
+        bool submit = false;
+        {
+            auto lock = std::lock_guard{state_->guard};
+            if (!state_->ready && state_->val) {
+                estimate = state_->val;
+                submit = !state_->scheduled && state_->load;
+                state_->scheduled = true;
+            }
+        }
+        if (!estimate)
+            return get();
+        if (submit)
+            schedule(task());
+        return estimate;
+    }
+
+    /// Blocks until the exact grid is computed
+    value_type get() const
+    {
+        run(state_);
+        auto lock = std::unique_lock{state_->guard};
+        state_->ready_cv.wait(
+            lock, [&] { return state_->ready || state_->error; });
+        if (!state_->ready)
+            std::rethrow_exception(state_->error);
+        return state_->val;
+    }
+
+    /// Returns a task that computes the exact grid if it is still needed
+    std::function<void()> task() const
+    {
+        return [wk = std::weak_ptr<state>{state_}] {
+            if (auto st = wk.lock())
+                run(st);
+        };
+    }
+
+private:
+    struct state {
+        std::mutex guard;
+        std::condition_variable ready_cv;
+        loader_type load;  ///< taken by the runner, returned if it fails
+        value_type val;
+        std::exception_ptr error;  ///< of the last run
+        bool ready = false;
+        bool scheduled = false;
+    };
+
+    std::shared_ptr<state> state_;
+
+    static void run(const std::shared_ptr<state>& st)
+    {
+        loader_type load;
+        {
+            auto lock = std::lock_guard{st->guard};
+            std::swap(load, st->load);
+            if (load)
+                st->error = nullptr;
+        }
+        if (!load)
+            return;
+        value_type val;
+        std::exception_ptr error;
+        try {
+            val = std::make_shared<geometry::box_rtree>(load());
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        {
+            auto lock = std::lock_guard{st->guard};
+            if (val) {
+                st->val = std::move(val);
+                st->ready = true;
+            }
+            else {
+                st->error = error;
+                st->load = std::move(load);
+                st->scheduled = false;
+            }
+        }
+        st->ready_cv.notify_all();
+    }
+};
+
 /// Describes column
 struct column {
     std::string name;
     column_type type = column_type::Invalid;
     std::string projection;  ///< PROJ.4 string for the spatial reference system
-    geometry::box_rtree tiles;  ///< balanced data grid
+    tile_grid tiles;
 
     sql_decoder decoder
 
@@ -39,6 +175,7 @@ struct column {
 struct index {
     index_type type = index_type::Invalid;
     std::vector<std::string> columns;
+    qualified_name name;  ///< empty if unknown
 };
 
 /// Describes table
@@ -57,9 +194,8 @@ inline std::ostream& operator<<(std::ostream& os, const column& col)
         std::vector<std::string> opts;
         if (!col.projection.empty())
             opts.push_back(proj::abbreviation(col.projection));
-        if (!col.tiles.empty())
-            opts.push_back(
-                concat("BOX", boost::geometry::dsv(bounds(col.tiles))));
+        if (auto tls = col.tiles.current(); tls && !tls->empty())
+            opts.push_back(concat("BOX", boost::geometry::dsv(bounds(*tls))));
         if (!opts.empty())
             os << " (" << list{opts, ", "} << ")";
     }
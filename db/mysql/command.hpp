@@ -62,12 +62,12 @@ public:
 
     void exec(const sql_builder& bld) override
     {
-        auto sql = bld.sql();
-        auto params = bld.params();
+        auto sql = bld.sql();  // null-terminated
+        auto& params = bld.params();
         auto r = prepare(sql);
         if (r != 0 && params.empty()) {
             reset_stmt(nullptr);
-            check(con_, !mysql_query(con_.get(), sql.c_str()));
+            check(con_, !mysql_query(con_.get(), sql.data()));
             for (int r = 0; r >= 0; r = mysql_next_result(con_.get())) {
                 check(con_, !r);
                 result_holder{mysql_store_result(con_.get())};
@@ -56,8 +56,9 @@ public:
     void exec(const sql_builder& bld) override
     {
         reset_res(nullptr);
-        auto sql = bld.sql();
-        auto params = bld.params();
+        drain();
+        auto sql = bld.sql();  // null-terminated
+        auto& params = bld.params();
 
         std::vector<param_holder> binds;
         std::vector<Oid> types;
@@ -72,22 +73,30 @@ public:
             lengths.push_back(bnd->length());
             formats.push_back(bnd->format());
         }
-        reset_res(PQexecParams(con_.get(),
-                               sql.c_str(),
-                               (int)params.size(),
-                               types.data(),
-                               values.data(),
-                               lengths.data(),
-                               formats.data(),
-                               PGRES_FORMAT_BINARY));
-
-        auto r = PQresultStatus(res_.get());
-        if (r != PGRES_COMMAND_OK && r != PGRES_TUPLES_OK && params.empty()) {
-            reset_res(PQexec(con_.get(), sql.c_str()));
-            r = PQresultStatus(res_.get());
+        check(con_,
+              PQsendQueryParams(con_.get(),
+                                sql.data(),
+                                (int)params.size(),
+                                types.data(),
+                                values.data(),
+                                lengths.data(),
+                                formats.data(),
+                                PGRES_FORMAT_BINARY));
+#ifdef LIBPQ_HAS_CHUNK_MODE
+        PQsetChunkedRowsMode(con_.get(), ChunkRows);
+#else
+        if (single_row_)
+            PQsetSingleRowMode(con_.get());
+#endif
+        reset_res(PQgetResult(con_.get()));
+
+        if (!succeeded(res_.get()) && params.empty()) {
+            reset_res(nullptr);
+            drain();
+            reset_res(PQexec(con_.get(), sql.data()));
         }
 
-        check(con_, r == PGRES_COMMAND_OK || r == PGRES_TUPLES_OK);
+        check(con_, succeeded(res_.get()));
     }
 
     std::vector<std::string> columns() override
@@ -107,8 +116,11 @@ public:
     {
         if (cols_.empty())
             columns();
-        if (cols_.empty() || row_ >= PQntuples(res_.get()))
+        if (cols_.empty())
             return false;
+        while (row_ >= PQntuples(res_.get()))
+            if (!next_chunk())
+                return false;
 
         auto row = row_++;
         for (size_t i = 0; i < cols_.size(); ++i) {
@@ -120,6 +132,10 @@ public:
         return true;
     }
 
+    /// Turns on the single-row mode, where every row costs a PGresult.
+    /// Chunks of rows are always streamed if libpq supports them.
+    void set_streaming(bool on) override { single_row_ = on; }
+
     void set_autocommit(bool autocommit) override
     {
         transaction::set_autocommit(autocommit);
@@ -128,10 +144,15 @@ public:
     void commit() override { transaction::commit(); }
 
 private:
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    static constexpr int ChunkRows = 1000;
+#endif
+
     connection_holder con_;
     result_holder res_;
     std::vector<column_holder> cols_;
     int row_ = 0;
+    bool single_row_ = false;
 
     void reset_res(PGresult* res)
     {
@@ -139,6 +160,43 @@ private:
         cols_.clear();
         res_.reset(res);
     }
+
+    static bool streamed(const PGresult* res)
+    {
+        auto r = PQresultStatus(res);
+#ifdef LIBPQ_HAS_CHUNK_MODE
+        if (r == PGRES_TUPLES_CHUNK)
+            return true;
+#endif
+        return r == PGRES_SINGLE_TUPLE;
+    }
+
+    static bool succeeded(const PGresult* res)
+    {
+        auto r = PQresultStatus(res);
+        return r == PGRES_COMMAND_OK || r == PGRES_TUPLES_OK || streamed(res);
+    }
+
+    /// Replaces the consumed part of the result with the next one.
+
+    /// Rows arrive in parts of bounded size, so the whole result is never
+    /// materialized on the client side.
+    bool next_chunk()
+    {
+        if (!streamed(res_.get()))
+            return false;
+        row_ = 0;
+        res_.reset(PQgetResult(con_.get()));
+        check(con_, succeeded(res_.get()));
+        return true;
+    }
+
+    /// Skips the rest of the previous query
+    void drain()
+    {
+        while (auto res = PQgetResult(con_.get()))
+            PQclear(res);
+    }
 };
 
 }  // namespace bark::db::postgres
@@ -52,6 +52,17 @@ struct provider {
                                    const geometry::box& extent,
                                    const geometry::box& pixel) = 0;
 
+    /// Returns @ref rowset with features under the cursor.
+
+    /// Columns are the same as in @ref spatial_objects. Geometries are
+    /// tested exactly, preferably against the cached tiles.
+    /// @param layer is a data set identifier;
+    /// @param extent is a small box around the cursor;
+    /// @param pixel selects the level of the raster pyramid.
+    virtual rowset pick(const qualified_name& layer,
+                        const geometry::box& extent,
+                        const geometry::box& pixel) = 0;
+
     /// Returns SQL command interface
     virtual command_holder make_command() = 0;
 
@@ -61,6 +72,14 @@ struct provider {
     /// Returns name and DDL command to create a table
     virtual std::pair<qualified_name, std::string> ddl(const meta::table&) = 0;
 
+    /// Returns commands to drop and to create a secondary index.
+
+    /// A bulk load runs between them, which is faster than updating the
+    /// index row by row. Both are empty if the index cannot be dropped.
+    virtual std::pair<std::string, std::string> index_ddl(
+        const meta::table&,
+        const meta::index&) = 0;
+
     /// Outputs SQL LIMIT clause
     virtual void page_clause(sql_builder&, size_t offset, size_t limit) = 0;
 
@@ -117,6 +136,135 @@ inline sql_builder select_sql(provider& pvd,
     return res;
 }
 
+/// Keyset pagination: returns the page of rows that follow the @p key.
+
+/// The rows are ordered by the primary key. Empty key means the first page.
+/// Unlike OFFSET, the cost of a page does not depend on its position.
+inline sql_builder select_sql(provider& pvd,
+                              const qualified_name& tbl_nm,
+                              const std::vector<variant_t>& key,
+                              size_t limit)
+{
+    auto res = builder(pvd);
+    auto tbl = pvd.table(tbl_nm);
+    auto pri =
+        boost::range::find_if(tbl.indexes, same{meta::index_type::Primary});
+    if (pri == tbl.indexes.end())
+        throw std::logic_error(concat("no primary key: ", tbl_nm));
+    auto& cols = pri->columns;
+    res << "SELECT " << list{tbl.columns, ", ", decode} << " FROM " << tbl_nm;
+    if (!key.empty()) {
+        // (k1 > v1) OR (k1 = v1 AND k2 > v2) OR ...
+        res << " WHERE ";
+        for (size_t i = 0; i < cols.size(); ++i) {
+            res << (i ? " OR (" : "(");
+            for (size_t j = 0; j < i; ++j)
+                res << id(cols[j]) << " = " << param{key[j]} << " AND ";
+            res << id(cols[i]) << " > " << param{key[i]} << ")";
+        }
+    }
+    res << " ORDER BY " << list{cols, ", ", id<>} << " ";
+    pvd.page_clause(res, 0, limit);
+    return res;
+}
+
+namespace detail {
+
+/// Fetches at most @p limit rows of the current query into the page data.
+
+/// Only the last row is decoded, its values refer to the page data.
+/// The page columns must be set already.
+/// @return the number of rows
+inline size_t fetch_page(command& cmd,
+                         size_t limit,
+                         rowset& page,
+                         std::vector<variant_t>& last_row)
+{
+    variant_ostream os;
+    size_t rows = 0;
+    size_t last_pos = 0;
+    for (; rows < limit; ++rows) {
+        auto pos = os.data.size();
+        if (!cmd.fetch(os))
+            break;
+        last_pos = pos;
+    }
+    page.data = std::move(os.data);
+    last_row.clear();
+    if (rows) {
+        auto is = variant_istream{page.data};
+        is.data.remove_prefix(last_pos);
+        for (size_t i = 0; i < page.columns.size(); ++i)
+            last_row.push_back(read(is));
+    }
+    return rows;
+}
+
+/// Keyset pagination on the command, see @ref db::for_each_page
+template <class Functor>
+void for_each_key_page(provider& pvd,
+                       command& cmd,
+                       const qualified_name& tbl_nm,
+                       const std::vector<size_t>& key_idxs,
+                       size_t limit,
+                       Functor f)
+{
+    std::vector<variant_t> key;
+    std::vector<variant_t> last_row;
+    rowset page;  ///< owns the key
+    for (;;) {
+        exec(cmd, select_sql(pvd, tbl_nm, key, limit));
+        page.columns = cmd.columns();
+        auto rows = fetch_page(cmd, limit, page, last_row);
+        if (!rows)
+            break;
+        f(page);
+        if (rows < limit)
+            break;
+        key = as<std::vector<variant_t>>(
+            key_idxs, [&](size_t idx) { return last_row[idx]; });
+    }
+}
+
+}  // namespace detail
+
+/// Calls the functor with consecutive pages of the table in linear time.
+
+/// Keyset pagination is used if the table has a primary key. Otherwise the
+/// pages are cut from one query, which the command streams, see
+/// @ref command::set_streaming.
+template <class Functor>
+void for_each_page(provider& pvd,
+                   const qualified_name& tbl_nm,
+                   size_t limit,
+                   Functor f)
+{
+    auto tbl = pvd.table(tbl_nm);
+    auto pri =
+        boost::range::find_if(tbl.indexes, same{meta::index_type::Primary});
+    auto cmd = pvd.make_command();
+    if (pri != tbl.indexes.end()) {
+        auto key_idxs = as<std::vector<size_t>>(pri->columns, [&](auto& col) {
+            return std::distance(tbl.columns.begin(),
+                                 db::find(tbl.columns, col));
+        });
+        detail::for_each_key_page(pvd, *cmd, tbl_nm, key_idxs, limit, f);
+        return;
+    }
+
+    cmd->set_streaming(true);
+    exec(*cmd,
+         builder(*cmd) << "SELECT " << list{tbl.columns, ", ", decode}
+                       << " FROM " << tbl_nm);
+    rowset page{cmd->columns(), {}};
+    std::vector<variant_t> last_row;
+    for (size_t rows = limit; rows == limit;) {
+        rows = detail::fetch_page(*cmd, limit, page, last_row);
+        if (rows)
+            f(page);
+    }
+}
+
 template <class ColumnNames, class Rows>
 sql_builder insert_sql(provider& pvd,
                        const qualified_name& tbl_nm,
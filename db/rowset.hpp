@@ -4,9 +4,12 @@
 #define BARK_DB_ROWSET_HPP
 
 #include <bark/db/variant.hpp>
+#include <bark/detail/trace.hpp>
 #include <bark/detail/unicode.hpp>
 #include <cctype>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace bark::db {
 
@@ -14,11 +17,109 @@ namespace bark::db {
 struct rowset {
     std::vector<std::string> columns;
     blob data;
+
+    /// Optional index built by @ref index: positions of all values in data
+    /// and its size. The value at row k and column j starts at
+    /// offsets[k * columns + j]. It is not kept in sync, so clear it when
+    /// data or columns change.
+    std::vector<size_t> offsets;
 };
 
+namespace detail {
+
+/// Appends positions of the values that follow the last offset
+inline void append_offsets(blob_view data, std::vector<size_t>& offsets)
+{
+    if (offsets.empty())
+        offsets.push_back(0);
+    auto is = variant_istream{data};
+    is.data.remove_prefix(offsets.back());
+    while (!is.data.empty()) {
+        skip(is);
+        offsets.push_back(data.size() - is.data.size());
+    }
+}
+
+}  // namespace detail
+
+inline bool indexed(const rowset& rs)
+{
+    return !rs.offsets.empty();
+}
+
+/// Builds @ref rowset::offsets in linear time
+inline void index(rowset& rs)
+{
+    if (!indexed(rs))
+        detail::append_offsets(rs.data, rs.offsets);
+}
+
+/// Returns the number of rows, in constant time if the rowset is indexed
+inline size_t row_count(const rowset& rs)
+{
+    if (rs.columns.empty())
+        return 0;
+    if (indexed(rs))
+        return (rs.offsets.size() - 1) / rs.columns.size();
+    size_t res = 0;
+    for (auto is = variant_istream{rs.data}; !is.data.empty(); ++res)
+        for (size_t i = 0; i < rs.columns.size(); ++i)
+            skip(is);
+    return res;
+}
+
+/// Returns encoded values of the rows [first, last) of the indexed rowset
+inline blob_view rows_data(const rowset& rs, size_t first, size_t last)
+{
+    auto cols = rs.columns.size();
+    auto pos = rs.offsets.at(first * cols);
+    return {rs.data.data() + pos, rs.offsets.at(last * cols) - pos};
+}
+
+/// Returns the value at the row and column of the indexed rowset
+inline variant_t get(const rowset& rs, size_t row, size_t col)
+{
+    if (col >= rs.columns.size())
+        throw std::out_of_range("rowset column");
+    if (row >= row_count(rs))
+        throw std::out_of_range("rowset row");
+    auto is = variant_istream{rs.data};
+    is.data.remove_prefix(rs.offsets.at(row * rs.columns.size() + col));
+    return read(is);
+}
+
+/// Copies the rows [first, last) of the indexed rowset with their index
+inline rowset slice(const rowset& rs, size_t first, size_t last)
+{
+    auto data = rows_data(rs, first, last);
+    auto cols = rs.columns.size();
+    auto pos = rs.offsets[first * cols];
+    auto res = rowset{rs.columns, blob(data.begin(), data.end()), {}};
+    res.offsets.reserve((last - first) * cols + 1);
+    for (auto i = first * cols; i <= last * cols; ++i)
+        res.offsets.push_back(rs.offsets[i] - pos);
+    return res;
+}
+
+/// Returns tuples of @ref variant_t for the rows [first, last) of the
+/// indexed rowset. Ranges can be decoded in parallel.
+inline auto select(const rowset& from, size_t first, size_t last)
+{
+    BARK_TRACE_SCOPE("db::select");
+    auto res = std::vector<std::vector<variant_t>>(last - first);
+    auto is = variant_istream{rows_data(from, first, last)};
+    for (auto& row : res)
+        for (auto& var : row = std::vector<variant_t>(from.columns.size()))
+            is >> var;
+    return res;
+}
+
 /// Returns tuples of @ref variant_t
 inline auto select(const rowset& from)
 {
+    if (indexed(from))
+        return select(from, 0, row_count(from));
+    BARK_TRACE_SCOPE("db::select");
     auto res = std::vector<std::vector<variant_t>>{};
     for (auto is = variant_istream{from.data}; !is.data.empty();)
         for (auto& var : res.emplace_back(from.columns.size()))
@@ -30,6 +131,7 @@ inline auto select(const rowset& from)
 template <class Columns>
 auto select(const Columns& cols, const rowset& from)
 {
+    BARK_TRACE_SCOPE("db::select");
     auto idxs = as<std::vector<size_t>>(from.columns, [&](auto&& col) {
         auto it = std::find(std::begin(cols), std::end(cols), col);
         return std::distance(std::begin(cols), it);
@@ -42,7 +144,7 @@ auto select(const Columns& cols, const rowset& from)
             if (idx < row.size())
                 is >> row[idx];
             else
-                read(is);
+                skip(is);
     }
     return res;
 }
@@ -0,0 +1,349 @@
+// Andrew Naplavkov
+
+#ifndef BARK_DB_SLIPPY_MVT_LAYER_HPP
+#define BARK_DB_SLIPPY_MVT_LAYER_HPP
+
+#include <algorithm>
+#include <bark/db/rowset.hpp>
+#include <bark/detail/protobuf.hpp>
+#include <bark/geometry/envelope.hpp>
+#include <bark/geometry/geom_from_wkb.hpp>
+#include <bark/geometry/geometry_ops.hpp>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+
+namespace bark::db::slippy {
+
+constexpr uint32_t MvtExtent = 4096;
+constexpr uint32_t MvtBuffer = 64;
+
+/// Encodes features into a layer of Mapbox Vector Tile (MVT).
+
+/// Geometries are clipped to the buffered tile and quantized to its grid.
+/// @see https://github.com/mapbox/vector-tile-spec/tree/master/2.1
+class mvt_layer {
+public:
+    /// @param ext is a tile extent in the projection of geometries;
+    /// @param extent is a number of grid cells along the tile edge;
+    /// @param buffer is a number of cells that are kept outside the edges.
+    mvt_layer(std::string name,
+              const geometry::box& ext,
+              uint32_t extent = MvtExtent,
+              uint32_t buffer = MvtBuffer)
+        : name_{std::move(name)}
+        , ext_{ext}
+        , extent_{extent}
+        , kx_{extent / geometry::width(ext)}
+        , ky_{extent / geometry::height(ext)}
+    {
+        auto dx = buffer / kx_;
+        auto dy = buffer / ky_;
+        clip_ = {{geometry::left(ext) - dx, geometry::bottom(ext) - dy},
+                 {geometry::right(ext) + dx, geometry::top(ext) + dy}};
+    }
+
+    /// Buffered tile extent in the projection of geometries
+    const geometry::box& clip_box() const { return clip_; }
+
+    bool empty() const { return features_.empty(); }
+
+    /// @param cols name the attributes;
+    /// @param row holds WKB in the first column and attributes in the rest.
+    void add(const std::vector<std::string>& cols,
+             const std::vector<variant_t>& row)
+    {
+        auto first = features_.size();
+        clip_and_encode(
+            geometry::geom_from_wkb(std::get<blob_view>(row.front())));
+        if (first == features_.size())
+            return;
+        std::vector<uint32_t> tags;
+        for (size_t i = 1; i < row.size(); ++i)
+            if (auto val = value(row[i]); !val.data.empty()) {
+                tags.push_back(index(keys_, cols[i]));
+                tags.push_back(index(
+                    values_,
+                    {reinterpret_cast<const char*>(val.data.data()),
+                     val.data.size()}));
+            }
+        for (auto it = features_.begin() + first; it != features_.end(); ++it)
+            it->tags = tags;
+    }
+
+    /// @param rows hold WKB in the first column and attributes in the rest.
+    void add(const rowset& rows)
+    {
+        for (auto& row : select(rows))
+            add(rows.columns, row);
+    }
+
+    /// Tile.Layer message
+    protobuf::ostream message() const
+    {
+        protobuf::ostream res;
+        res.varint(15, 2).bytes(1, name_);
+        for (auto& feature : features_) {
+            protobuf::ostream msg;
+            if (!feature.tags.empty())
+                msg.packed(2, feature.tags);
+            msg.varint(3, feature.type).packed(4, feature.cmds);
+            res.message(2, msg);
+        }
+        for (auto& key : sorted(keys_))
+            res.bytes(3, key);
+        for (auto& val : sorted(values_))
+            res.bytes(4, val);
+        res.varint(5, extent_);
+        return res;
+    }
+
+private:
+    enum geom_type : uint32_t { Point = 1, Linestring = 2, Polygon = 3 };
+    enum command_id : uint32_t { MoveTo = 1, LineTo = 2, ClosePath = 7 };
+
+    struct cell {
+        int32_t x;
+        int32_t y;
+
+        friend bool operator==(const cell& lhs, const cell& rhs)
+        {
+            return lhs.x == rhs.x && lhs.y == rhs.y;
+        }
+    };
+
+    struct feature {
+        geom_type type;
+        std::vector<uint32_t> tags;
+        std::vector<uint32_t> cmds;
+    };
+
+    using path = std::vector<cell>;
+    using dictionary = std::unordered_map<std::string, uint32_t>;
+
+    std::string name_;
+    geometry::box ext_;
+    geometry::box clip_;
+    uint32_t extent_;
+    double kx_;
+    double ky_;
+    dictionary keys_;
+    dictionary values_;
+    std::vector<feature> features_;
+
+    struct encoder {
+        std::vector<uint32_t> cmds;
+        cell cursor{0, 0};
+
+        void command(uint32_t id, size_t count)
+        {
+            cmds.push_back((id & 0x7) | static_cast<uint32_t>(count) << 3);
+        }
+
+        void parameter(const cell& val)
+        {
+            cmds.push_back(protobuf::zigzag(val.x - cursor.x));
+            cmds.push_back(protobuf::zigzag(val.y - cursor.y));
+            cursor = val;
+        }
+    };
+
+    static protobuf::ostream value(const variant_t& var)
+    {
+        protobuf::ostream res;
+        std::visit(overloaded{[](std::monostate) {},
+                              [](blob_view) {},
+                              [&](std::string_view v) { res.bytes(1, v); },
+                              [&](double v) { res.fixed64(3, v); },
+                              [&](int64_t v) {
+                                  if (v < 0)
+                                      res.varint(6, protobuf::zigzag(v));
+                                  else
+                                      res.varint(5, static_cast<uint64_t>(v));
+                              }},
+                   var);
+        return res;
+    }
+
+    static uint32_t index(dictionary& dict, std::string key)
+    {
+        auto idx = static_cast<uint32_t>(dict.size());
+        return dict.try_emplace(std::move(key), idx).first->second;
+    }
+
+    static std::vector<std::string> sorted(const dictionary& dict)
+    {
+        std::vector<std::string> res(dict.size());
+        for (auto& [key, idx] : dict)
+            res[idx] = key;
+        return res;
+    }
+
+    static int64_t doubled_area(const path& ring)
+    {
+        int64_t res = 0;
+        for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+            res += int64_t{ring[j].x} * ring[i].y -
+                   int64_t{ring[i].x} * ring[j].y;
+        return res;
+    }
+
+    cell quantize(const geometry::point& val) const
+    {
+        using geometry::left, geometry::top;
+        return {static_cast<int32_t>(std::lround((val.x() - left(ext_)) * kx_)),
+                static_cast<int32_t>(std::lround((top(ext_) - val.y()) * ky_))};
+    }
+
+    template <class Points>
+    path quantize(const Points& points) const
+    {
+        path res;
+        res.reserve(points.size());
+        for (auto& val : points)
+            if (auto c = quantize(val); res.empty() || !(res.back() == c))
+                res.push_back(c);
+        return res;
+    }
+
+    /// Returns an open ring or nothing if it collapses
+    path quantize_ring(const geometry::polygon::ring_type& ring) const
+    {
+        auto res = quantize(ring);
+        if (res.size() > 1 && res.front() == res.back())
+            res.pop_back();
+        if (res.size() < 3)
+            res.clear();
+        return res;
+    }
+
+    void add_feature(geom_type type, encoder& enc)
+    {
+        if (!enc.cmds.empty())
+            features_.push_back({type, {}, std::move(enc.cmds)});
+    }
+
+    void encode(const geometry::multi_point& geom)
+    {
+        path cells;
+        for (auto& val : geom)
+            if (boost::geometry::covered_by(val, clip_))
+                cells.push_back(quantize(val));
+        encoder enc;
+        if (!cells.empty()) {
+            enc.command(MoveTo, cells.size());
+            for (auto& val : cells)
+                enc.parameter(val);
+        }
+        add_feature(Point, enc);
+    }
+
+    void encode(const geometry::multi_linestring& geom)
+    {
+        encoder enc;
+        for (auto& line : geom) {
+            auto cells = quantize(line);
+            if (cells.size() < 2)
+                continue;
+            enc.command(MoveTo, 1);
+            enc.parameter(cells.front());
+            enc.command(LineTo, cells.size() - 1);
+            for (auto it = std::next(cells.begin()); it != cells.end(); ++it)
+                enc.parameter(*it);
+        }
+        add_feature(Linestring, enc);
+    }
+
+    void encode(const geometry::multi_polygon& geom)
+    {
+        encoder enc;
+        auto ring_to = [&](path& ring, bool exterior) {
+            auto area = doubled_area(ring);
+            if (!area)
+                return false;
+            if ((area > 0) != exterior)  // exterior is clockwise if y is down
+                std::reverse(ring.begin(), ring.end());
+            enc.command(MoveTo, 1);
+            enc.parameter(ring.front());
+            enc.command(LineTo, ring.size() - 1);
+            for (auto it = std::next(ring.begin()); it != ring.end(); ++it)
+                enc.parameter(*it);
+            enc.command(ClosePath, 1);
+            return true;
+        };
+        for (auto& poly : geom) {
+            auto outer = quantize_ring(poly.outer());
+            if (outer.empty() || !ring_to(outer, true))
+                continue;
+            for (auto& inner : poly.inners())
+                if (auto ring = quantize_ring(inner); !ring.empty())
+                    ring_to(ring, false);
+        }
+        add_feature(Polygon, enc);
+    }
+
+    template <class Geometry, class Clipped>
+    void clip_and_encode(const Geometry& geom)
+    {
+        Clipped res;
+        if (boost::geometry::covered_by(geometry::envelope(geom), clip_))
+            boost::geometry::convert(geom, res);
+        else
+            try {
+                boost::geometry::intersection(geom, clip_, res);
+            }
+            catch (const boost::geometry::exception&) {
+                boost::geometry::convert(geom, res);  // invalid input
+            }
+        encode(res);
+    }
+
+    void clip_and_encode(const geometry::point& geom)
+    {
+        encode(geometry::multi_point{geom});
+    }
+
+    void clip_and_encode(const geometry::multi_point& geom)
+    {
+        encode(geom);
+    }
+
+    void clip_and_encode(const geometry::linestring& geom)
+    {
+        clip_and_encode<geometry::linestring, geometry::multi_linestring>(
+            geom);
+    }
+
+    void clip_and_encode(const geometry::multi_linestring& geom)
+    {
+        clip_and_encode<geometry::multi_linestring,
+                        geometry::multi_linestring>(geom);
+    }
+
+    void clip_and_encode(const geometry::polygon& geom)
+    {
+        clip_and_encode<geometry::polygon, geometry::multi_polygon>(geom);
+    }
+
+    void clip_and_encode(const geometry::multi_polygon& geom)
+    {
+        clip_and_encode<geometry::multi_polygon, geometry::multi_polygon>(
+            geom);
+    }
+
+    void clip_and_encode(const geometry::geometry_collection& geom)
+    {
+        for (auto& item : geom)
+            clip_and_encode(item);
+    }
+
+    void clip_and_encode(const geometry::geometry& geom)
+    {
+        boost::apply_visitor([&](auto& item) { clip_and_encode(item); },
+                             geom);
+    }
+};
+
+}  // namespace bark::db::slippy
+
+#endif  // BARK_DB_SLIPPY_MVT_LAYER_HPP
@@ -0,0 +1,120 @@
+// Andrew Naplavkov
+
+#ifndef BARK_DB_SLIPPY_MBTILES_HPP
+#define BARK_DB_SLIPPY_MBTILES_HPP
+
+#include <bark/db/slippy/detail/tile.hpp>
+#include <bark/db/sqlite/command.hpp>
+#include <string>
+
+namespace bark::db::slippy {
+
+/// Tileset storage in a single SQLite file.
+
+/// Not thread-safe. Tiles are written in transactions of @ref commit calls.
+/// Empty tiles are only marked in the extra table empty_tiles, so readers
+/// of the tiles table do not see them, while a resumed seeding skips them.
+/// @see https://github.com/mapbox/mbtiles-spec/blob/master/1.3/spec.md
+class mbtiles {
+public:
+    explicit mbtiles(const std::string& file) : cmd_{file}
+    {
+        exec(cmd_,
+             "CREATE TABLE IF NOT EXISTS metadata (name text, value text);\n"
+             "CREATE TABLE IF NOT EXISTS tiles (zoom_level integer, "
+             "tile_column integer, tile_row integer, tile_data blob);\n"
+             "CREATE UNIQUE INDEX IF NOT EXISTS tile_index "
+             "ON tiles (zoom_level, tile_column, tile_row);\n"
+             "CREATE TABLE IF NOT EXISTS empty_tiles (zoom_level integer, "
+             "tile_column integer, tile_row integer);\n"
+             "CREATE UNIQUE INDEX IF NOT EXISTS empty_tile_index "
+             "ON empty_tiles (zoom_level, tile_column, tile_row);");
+        cmd_.set_autocommit(false);
+    }
+
+    ~mbtiles()
+    try {
+        cmd_.commit();
+    }
+    catch (const std::exception&) {
+    }
+
+    /// @param name is one of: name, format, bounds, center, minzoom, etc.
+    void set_metadata(std::string_view name, std::string_view value)
+    {
+        exec(cmd_,
+             builder(cmd_) << "DELETE FROM metadata WHERE name = "
+                           << param{name});
+        exec(cmd_,
+             builder(cmd_) << "INSERT INTO metadata (name, value) VALUES ("
+                           << param{name} << ", " << param{value} << ")");
+    }
+
+    /// Returns the value or empty string if there is none
+    std::string metadata(std::string_view name)
+    {
+        exec(cmd_,
+             builder(cmd_) << "SELECT value FROM metadata WHERE name = "
+                           << param{name});
+        auto rows = fetch_all(cmd_);
+        for (auto is = variant_istream{rows.data}; !is.data.empty();) {
+            auto val = read(is);
+            if (auto str = std::get_if<std::string_view>(&val))
+                return std::string{*str};
+        }
+        return {};
+    }
+
+    /// Returns the stored and empty tiles from the zoom levels range
+    tiles stored(int zmin, int zmax)
+    {
+        exec(cmd_,
+             builder(cmd_) << "SELECT zoom_level, tile_column, tile_row FROM "
+                              "tiles WHERE zoom_level BETWEEN "
+                           << param{zmin} << " AND " << param{zmax}
+                           << " UNION ALL SELECT zoom_level, tile_column, "
+                              "tile_row FROM empty_tiles WHERE zoom_level "
+                              "BETWEEN "
+                           << param{zmin} << " AND " << param{zmax});
+        tiles res;
+        auto rows = fetch_all(cmd_);
+        for (auto is = variant_istream{rows.data}; !is.data.empty();) {
+            auto z = (int)std::get<int64_t>(read(is));
+            auto x = (int)std::get<int64_t>(read(is));
+            auto y = (int)std::get<int64_t>(read(is));
+            res.push_back({x, flipped(y, z), z});
+        }
+        return res;
+    }
+
+    /// Empty @p data only marks the tile as seeded
+    void insert(const tile& tl, blob_view data)
+    {
+        if (data.empty()) {
+            exec(cmd_,
+                 builder(cmd_) << "INSERT OR REPLACE INTO empty_tiles "
+                                  "(zoom_level, tile_column, tile_row) VALUES ("
+                               << param{tl.z} << ", " << param{tl.x} << ", "
+                               << param{flipped(tl.y, tl.z)} << ")");
+            return;
+        }
+        exec(cmd_,
+             builder(cmd_) << "INSERT OR REPLACE INTO tiles (zoom_level, "
+                              "tile_column, tile_row, tile_data) VALUES ("
+                           << param{tl.z} << ", " << param{tl.x} << ", "
+                           << param{flipped(tl.y, tl.z)} << ", " << param{data}
+                           << ")");
+    }
+
+    void commit() { cmd_.commit(); }
+
+private:
+    sqlite::command cmd_;
+
+    /// MBTiles uses the TMS scheme with the origin at the bottom
+    static int flipped(int y, int z) { return (1 << z) - 1 - y; }
+};
+
+}  // namespace bark::db::slippy
+
+#endif  // BARK_DB_SLIPPY_MBTILES_HPP
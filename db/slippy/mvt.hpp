@@ -0,0 +1,66 @@
+// Andrew Naplavkov
+
+#ifndef BARK_DB_SLIPPY_MVT_HPP
+#define BARK_DB_SLIPPY_MVT_HPP
+
+#include <bark/db/provider.hpp>
+#include <bark/db/slippy/detail/layer.hpp>
+#include <bark/db/slippy/detail/mvt_layer.hpp>
+#include <bark/db/slippy/detail/tile.hpp>
+#include <bark/geometry/envelope.hpp>
+#include <bark/proj/transformer.hpp>
+
+namespace bark::db::slippy {
+
+/// Encodes geometry layers of the provider into Mapbox Vector Tile (MVT).
+
+/// Objects are loaded by the data tiles of the provider, so they are shared
+/// with map rendering through the cache. An object that spans several data
+/// tiles is encoded once.
+/// Layers are named after tables.
+/// @param extent is a number of grid cells along the tile edge;
+/// @param buffer is a number of cells that are kept outside the edges.
+inline blob make_mvt(provider& pvd,
+                     const std::vector<qualified_name>& lrs,
+                     const tile& tl,
+                     uint32_t extent = MvtExtent,
+                     uint32_t buffer = MvtBuffer)
+{
+    auto ext = tile_to_layer_transformer().forward(slippy::extent(tl));
+    auto px = geometry::box{
+        ext.min_corner(),
+        {geometry::left(ext) + geometry::width(ext) / extent,
+         geometry::bottom(ext) + geometry::height(ext) / extent}};
+    protobuf::ostream res;
+    for (auto& lr_nm : lrs) {
+        auto lr = mvt_layer{lr_nm.at(-2), ext, extent, buffer};
+        auto tf = proj::transformer{pvd.projection(lr_nm), projection()};
+        auto lr_ext = tf.backward(lr.clip_box());
+        auto lr_px = tf.backward(px);
+        auto tiles = pvd.tile_coverage(lr_nm, lr_ext, lr_px);
+        for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+            auto rows = pvd.spatial_objects(lr_nm, *it, lr_px);
+            for (auto& row : select(rows)) {
+                auto wkb = std::get<blob_view>(row.front());
+                if (it != tiles.begin()) {
+                    auto env = geometry::envelope(geometry::geom_from_wkb(wkb));
+                    auto owner = std::find_if(tiles.begin(), it, [&](auto& t) {
+                        return boost::geometry::intersects(env, t);
+                    });
+                    if (owner != it)
+                        continue;  // already encoded
+                }
+                if (!tf.is_trivial())
+                    tf.inplace_forward(wkb);
+                lr.add(rows.columns, row);
+            }
+        }
+        if (!lr.empty())
+            res.message(3, lr.message());
+    }
+    return std::move(res.data);
+}
+
+}  // namespace bark::db::slippy
+
+#endif  // BARK_DB_SLIPPY_MVT_HPP
@@ -60,6 +60,13 @@ public:
         return cached_spatial_objects(lr_nm, ext, px);
     }
 
+    rowset pick(const qualified_name& lr_nm,
+                const geometry::box& ext,
+                const geometry::box& px) override
+    {
+        return cached_pick(lr_nm, ext, px, false);
+    }
+
     command_holder make_command() override
     {
         throw std::logic_error{"not implemented"};
@@ -75,6 +82,12 @@ public:
         throw std::logic_error{"not implemented"};
     }
 
+    std::pair<std::string, std::string> index_ddl(const meta::table&,
+                                                  const meta::index&) override
+    {
+        throw std::logic_error{"not implemented"};
+    }
+
     void page_clause(sql_builder&, size_t, size_t) override
     {
         throw std::logic_error{"not implemented"};
@@ -0,0 +1,244 @@
+// Andrew Naplavkov
+
+#ifndef BARK_DB_SLIPPY_SEEDER_HPP
+#define BARK_DB_SLIPPY_SEEDER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bark/db/provider.hpp>
+#include <bark/db/slippy/detail/tile.hpp>
+#include <bark/db/slippy/mbtiles.hpp>
+#include <bark/detail/bounded_queue.hpp>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace bark::db::slippy {
+
+/// Returns the tile data or empty blob if there is nothing to store
+using tile_encoder = std::function<blob(const tile&)>;
+
+struct seeding_stats {
+    using duration = std::chrono::duration<double>;
+
+    size_t stored = 0;
+    size_t skipped = 0;  ///< present from the previous run
+    size_t empty = 0;  ///< marked as seeded
+    size_t bytes = 0;
+    duration walking{};
+    duration encoding{};  ///< summed over threads
+    duration writing{};
+    duration total{};
+
+    double tiles_per_second() const
+    {
+        auto secs = total.count();
+        return secs > 0 ? (stored + empty) / secs : 0;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const seeding_stats& that)
+    {
+        return os << std::fixed << std::setprecision(3)
+                  << "stored: " << that.stored << " (" << that.bytes
+                  << " bytes), empty: " << that.empty
+                  << ", skipped: " << that.skipped
+                  << ", tiles/sec: " << that.tiles_per_second()
+                  << ", walking: " << that.walking.count()
+                  << "s, encoding: " << that.encoding.count()
+                  << "s, writing: " << that.writing.count()
+                  << "s, total: " << that.total.count() << "s";
+    }
+};
+
+namespace detail {
+
+inline uint64_t tile_key(const tile& tl)
+{
+    return uint64_t(tl.z) << 58 | uint64_t(tl.x) << 29 | uint64_t(tl.y);
+}
+
+/// Visits tiles of the zoom level in depth-first order of their ancestors
+template <class Functor>
+void for_each_tile(const geometry::box& lon_lat, int z, Functor f)
+{
+    static constexpr int Depth = 8;  // at most 4^8 tiles in memory
+    auto filter = [&](int zmax) {
+        return [&, zmax](const tile& tl) {
+            return tl.z <= zmax &&
+                   boost::geometry::intersects(lon_lat, extent(tl));
+        };
+    };
+    for (auto& parent : depth_first_search(filter(std::max(0, z - Depth)))) {
+        if (parent.z != std::max(0, z - Depth))
+            continue;
+        tiles tls;
+        depth_first_search(tls, parent, filter(z));
+        for (auto& tl : tls)
+            if (tl.z == z)
+                f(tl);
+    }
+}
+
+/// MBTiles bounds: left, bottom, right, top
+inline std::string bounds(const geometry::box& lon_lat)
+{
+    std::ostringstream os;
+    os << std::setprecision(10) << geometry::left(lon_lat) << ','
+       << geometry::bottom(lon_lat) << ',' << geometry::right(lon_lat) << ','
+       << geometry::top(lon_lat);
+    return os.str();
+}
+
+}  // namespace detail
+
+/// Pre-generates a tile pyramid and stores it in MBTiles.
+
+/// Tiles are encoded in parallel and written by the calling thread in
+/// periodic transactions. Queues between the stages are bounded, so memory
+/// does not depend on the number of tiles. Empty tiles are marked as seeded,
+/// so an interrupted seeding is resumed without encoding any tile twice.
+/// The metadata name, format, bounds, minzoom and maxzoom describe this run.
+/// @code
+/// slippy::seed(dest, "roads", "pbf", lon_lat, 0, 14, [&](auto& tl) {
+///     return slippy::make_mvt(*pvd, lrs, tl);
+/// });
+/// @endcode
+/// @param format is one of: pbf, png, jpg, webp;
+/// @param lon_lat is a bounding box in EPSG:4326;
+/// @param encode is called concurrently.
+inline seeding_stats seed(
+    mbtiles& dest,
+    std::string_view name,
+    std::string_view format,
+    const geometry::box& lon_lat,
+    int zmin,
+    int zmax,
+    tile_encoder encode,
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency()))
+{
+    using namespace std::chrono;
+    using clock = steady_clock;
+    static constexpr auto CommitInterval = seconds(3);
+    static constexpr auto MaxBackoff = milliseconds(200);
+
+    seeding_stats res;
+    auto start = clock::now();
+    dest.set_metadata("name", name);
+    dest.set_metadata("format", format);
+    dest.set_metadata("bounds", detail::bounds(lon_lat));
+    dest.set_metadata("minzoom", std::to_string(zmin));
+    dest.set_metadata("maxzoom", std::to_string(zmax));
+    std::unordered_set<uint64_t> stored;
+    for (auto& tl : dest.stored(zmin, zmax))
+        stored.insert(detail::tile_key(tl));
+
+    bounded_queue<tile> todo(threads * 4);
+    bounded_queue<std::pair<tile, blob>> done(threads * 4);
+    std::mutex guard;
+    std::exception_ptr error;
+    std::atomic<clock::duration::rep> encoding{0};
+    auto fail = [&] {
+        {
+            auto lock = std::lock_guard{guard};
+            if (!error)
+                error = std::current_exception();
+        }
+        todo.close();
+        done.close();
+    };
+
+    std::thread walker([&] {
+        try {
+            for (int z = zmin; z <= zmax; ++z)
+                detail::for_each_tile(lon_lat, z, [&](const tile& tl) {
+                    if (stored.count(detail::tile_key(tl)))
+                        ++res.skipped;
+                    else if (!todo.push(tl))
+                        throw std::runtime_error("seeding aborted");
+                });
+        }
+        catch (...) {
+            fail();
+        }
+        todo.close();
+        res.walking = clock::now() - start;
+    });
+
+    std::atomic<unsigned> running{threads};
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back([&] {
+            try {
+                while (auto tl = todo.pop()) {
+                    auto first = clock::now();
+                    blob data;
+                    // a busy cache is retried with an exponential backoff
+                    for (auto backoff = milliseconds(1);;)
+                        try {
+                            data = encode(*tl);
+                            break;
+                        }
+                        catch (const busy_exception&) {
+                            std::this_thread::sleep_for(backoff);
+                            backoff = std::min(backoff * 2, MaxBackoff);
+                        }
+                    encoding += (clock::now() - first).count();
+                    if (!done.push({*tl, std::move(data)}))
+                        break;
+                }
+            }
+            catch (...) {
+                fail();
+            }
+            if (!--running)
+                done.close();
+        });
+
+    auto last_commit = clock::now();
+    try {
+        while (auto item = done.pop()) {
+            auto& [tl, data] = *item;
+            auto first = clock::now();
+            dest.insert(tl, data);
+            if (first - last_commit > CommitInterval) {
+                dest.commit();
+                last_commit = clock::now();
+            }
+            res.writing += clock::now() - first;
+            if (data.empty())
+                ++res.empty;
+            else {
+                ++res.stored;
+                res.bytes += data.size();
+            }
+        }
+        auto first = clock::now();
+        dest.commit();
+        res.writing += clock::now() - first;
+    }
+    catch (...) {
+        fail();
+    }
+
+    walker.join();
+    for (auto& worker : workers)
+        worker.join();
+    if (error)
+        std::rethrow_exception(error);
+    res.encoding = clock::duration(encoding.load());
+    res.total = clock::now() - start;
+    return res;
+}
+
+}  // namespace bark::db::slippy
+
+#endif  // BARK_DB_SLIPPY_SEEDER_HPP
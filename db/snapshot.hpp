@@ -0,0 +1,327 @@
+// Andrew Naplavkov
+
+#ifndef BARK_DB_SNAPSHOT_HPP
+#define BARK_DB_SNAPSHOT_HPP
+
+#include <bark/db/rowset.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Read-only rowset layout that is used in place, e.g. memory-mapped.
+
+/// Version 1. Integers are in the native byte order, which is recorded in
+/// the header. Every section starts at a multiple of eight bytes.
+/// | offset    | size          | content                               |
+/// | --------- | ------------- | ------------------------------------- |
+/// | 0         | 8             | magic "BARKRWS\0"                     |
+/// | 8         | 4             | uint32 version                        |
+/// | 12        | 4             | uint32 byte order mark 0x01020304     |
+/// | 16        | 8             | uint64 number of columns C            |
+/// | 24        | 8             | uint64 number of rows R               |
+/// | 32        | 8             | uint64 size of names N                |
+/// | 40        | 8             | uint64 size of data D                 |
+/// | 48        | 8 * (C + 1)   | uint64 offsets of names               |
+/// | ...       | N, padded     | names in UTF-8 without terminators    |
+/// | ...       | 8 * (R + 1)   | uint64 offsets of rows in data        |
+/// | ...       | D, padded     | rows encoded as in @ref rowset::data  |
+/// The size of the snapshot is exactly the sum of the sections.
+namespace bark::db {
+namespace detail {
+
+inline constexpr char SnapshotMagic[8] = {'B', 'A', 'R', 'K', 'R', 'W', 'S'};
+inline constexpr uint32_t SnapshotVersion = 1;
+inline constexpr uint32_t SnapshotByteOrder = 0x01020304;
+
+struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t columns;
+    uint64_t rows;
+    uint64_t names_size;
+    uint64_t data_size;
+};
+
+static_assert(sizeof(snapshot_header) == 48);
+
+constexpr uint64_t align8(uint64_t size)
+{
+    return (size + 7) & ~uint64_t(7);
+}
+
+/// Moves past a value, returns false if it is malformed or truncated
+inline bool skip_variant(blob_view& src)
+{
+    auto skip = [&](uint64_t size) {
+        if (src.size() < size)
+            return false;
+        src.remove_prefix(size);
+        return true;
+    };
+    auto skip_sized = [&](uint64_t tail) {
+        size_t size;
+        if (src.size() < sizeof size)
+            return false;
+        std::memcpy(&size, src.data(), sizeof size);
+        src.remove_prefix(sizeof size);
+        if (src.size() < tail || src.size() - tail < size)
+            return false;
+        if (tail && src[size] != std::byte{0})
+            return false;
+        src.remove_prefix(size + tail);
+        return true;
+    };
+    if (src.empty())
+        return false;
+    auto tag = std::to_integer<uint8_t>(src.front());
+    src.remove_prefix(1);
+    switch (tag) {
+        case variant_index<variant_t, std::monostate>():
+            return true;
+        case variant_index<variant_t, int64_t>():
+            return skip(sizeof(int64_t));
+        case variant_index<variant_t, double>():
+            return skip(sizeof(double));
+        case variant_index<variant_t, std::string_view>():
+            return skip_sized(1);  // zero terminated
+        case variant_index<variant_t, blob_view>():
+            return skip_sized(0);
+    }
+    return false;
+}
+
+/// Unchecked substring
+inline blob_view slice(blob_view src, uint64_t pos, uint64_t count)
+{
+    return {src.data() + pos, count};
+}
+
+template <class T>
+const T* snapshot_array(blob_view src, uint64_t pos)
+{
+    return reinterpret_cast<const T*>(src.data() + pos);
+}
+
+/// @return an error message or nullptr if the snapshot is consistent
+inline const char* check_snapshot(blob_view src)
+{
+    snapshot_header hdr;
+    if (src.size() < sizeof hdr)
+        return "truncated header";
+    if (reinterpret_cast<uintptr_t>(src.data()) % alignof(uint64_t))
+        return "misaligned";
+    std::memcpy(&hdr, src.data(), sizeof hdr);
+    if (std::memcmp(hdr.magic, SnapshotMagic, sizeof hdr.magic))
+        return "magic";
+    if (hdr.version != SnapshotVersion)
+        return "version";
+    if (hdr.byte_order != SnapshotByteOrder)
+        return "byte order";
+    uint64_t size = src.size();
+    if (hdr.columns > size / 8 || hdr.rows > size / 8 ||
+        hdr.names_size > size || hdr.data_size > size)
+        return "size";
+    auto names_pos = sizeof hdr + 8 * (hdr.columns + 1);
+    auto rows_pos = names_pos + align8(hdr.names_size);
+    auto data_pos = rows_pos + 8 * (hdr.rows + 1);
+    if (data_pos + align8(hdr.data_size) != size)
+        return "size";
+
+    auto names = snapshot_array<uint64_t>(src, sizeof hdr);
+    if (names[0] || names[hdr.columns] != hdr.names_size)
+        return "names";
+    for (uint64_t i = 0; i < hdr.columns; ++i)
+        if (names[i] > names[i + 1])
+            return "names";
+
+    auto rows = snapshot_array<uint64_t>(src, rows_pos);
+    if (rows[0] || rows[hdr.rows] != hdr.data_size)
+        return "rows";
+    if (!hdr.columns && hdr.data_size)
+        return "rows";
+    auto data = slice(src, data_pos, hdr.data_size);
+    for (uint64_t i = 0; i < hdr.rows; ++i) {
+        if (rows[i] > rows[i + 1] || rows[i + 1] > hdr.data_size)
+            return "rows";
+        auto row = slice(data, rows[i], rows[i + 1] - rows[i]);
+        for (uint64_t j = 0; j < hdr.columns; ++j)
+            if (!skip_variant(row))
+                return "values";
+        if (!row.empty())
+            return "values";
+    }
+    return nullptr;
+}
+
+}  // namespace detail
+
+/// Serializes the rowset into the snapshot layout
+inline blob make_snapshot(const rowset& from)
+{
+    BARK_TRACE_SCOPE("db::make_snapshot");
+    detail::snapshot_header hdr{};
+    std::memcpy(hdr.magic, detail::SnapshotMagic, sizeof hdr.magic);
+    hdr.version = detail::SnapshotVersion;
+    hdr.byte_order = detail::SnapshotByteOrder;
+    hdr.columns = from.columns.size();
+    hdr.data_size = from.data.size();
+
+    std::vector<uint64_t> names{0};
+    for (auto& col : from.columns)
+        names.push_back(names.back() + col.size());
+    hdr.names_size = names.back();
+
+    std::vector<uint64_t> rows{0};
+    if (indexed(from) && hdr.columns)
+        for (size_t i = 1, n = row_count(from); i <= n; ++i)
+            rows.push_back(from.offsets[i * hdr.columns]);
+    blob_view data = from.data;
+    data.remove_prefix(rows.back());
+    while (hdr.columns && !data.empty()) {
+        for (uint64_t i = 0; i < hdr.columns; ++i)
+            if (!detail::skip_variant(data))
+                throw std::runtime_error("invalid rowset");
+        rows.push_back(from.data.size() - data.size());
+    }
+    hdr.rows = rows.size() - 1;
+
+    auto pad = [](blob& dest) { dest.resize(detail::align8(dest.size())); };
+    blob res;
+    res.reserve(sizeof hdr + 8 * (names.size() + rows.size()) +
+                detail::align8(hdr.names_size) +
+                detail::align8(hdr.data_size));
+    write(reinterpret_cast<const char*>(&hdr), sizeof hdr, res);
+    write(names.data(), names.size(), res);
+    for (auto& col : from.columns)
+        write(col.data(), col.size(), res);
+    pad(res);
+    write(rows.data(), rows.size(), res);
+    res.insert(res.end(), from.data.begin(), from.data.end());
+    pad(res);
+    return res;
+}
+
+/// Returns true if the bytes are a consistent snapshot. Every row is
+/// parsed, so untrusted input is rejected before it is read.
+inline bool is_snapshot(blob_view src) noexcept
+{
+    return !detail::check_snapshot(src);
+}
+
+/// Reads the snapshot in place without copying the values.
+
+/// The bytes must outlive the view and the values selected from it.
+class snapshot_view {
+public:
+    /// @throw std::runtime_error if the snapshot is inconsistent
+    explicit snapshot_view(blob_view src) : src_{src}
+    {
+        if (auto err = detail::check_snapshot(src))
+            throw std::runtime_error(concat("invalid snapshot: ", err));
+        std::memcpy(&hdr_, src.data(), sizeof hdr_);
+        names_ = detail::snapshot_array<uint64_t>(src, sizeof hdr_);
+        names_pos_ = sizeof hdr_ + 8 * (hdr_.columns + 1);
+        auto rows_pos = names_pos_ + detail::align8(hdr_.names_size);
+        rows_ = detail::snapshot_array<uint64_t>(src, rows_pos);
+        data_ = detail::slice(
+            src, rows_pos + 8 * (hdr_.rows + 1), hdr_.data_size);
+    }
+
+    size_t columns_size() const { return hdr_.columns; }
+
+    std::string_view column(size_t idx) const
+    {
+        return {reinterpret_cast<const char*>(src_.data()) + names_pos_ +
+                    names_[idx],
+                names_[idx + 1] - names_[idx]};
+    }
+
+    std::vector<std::string> columns() const
+    {
+        std::vector<std::string> res;
+        for (size_t i = 0; i < columns_size(); ++i)
+            res.emplace_back(column(i));
+        return res;
+    }
+
+    /// Number of rows
+    size_t size() const { return hdr_.rows; }
+
+    /// Encoded values of the row
+    blob_view row(size_t idx) const
+    {
+        return detail::slice(data_, rows_[idx], rows_[idx + 1] - rows_[idx]);
+    }
+
+    /// Encoded values of all rows
+    blob_view data() const { return data_; }
+
+    /// Copies the snapshot back
+    operator rowset() const
+    {
+        return {columns(), blob(data_.begin(), data_.end())};
+    }
+
+private:
+    blob_view src_;
+    detail::snapshot_header hdr_;
+    const uint64_t* names_;
+    uint64_t names_pos_;
+    const uint64_t* rows_;
+    blob_view data_;
+};
+
+/// Returns tuples of @ref variant_t that refer to the snapshot
+inline auto select(const snapshot_view& from)
+{
+    BARK_TRACE_SCOPE("db::select");
+    auto res = std::vector<std::vector<variant_t>>(from.size());
+    for (size_t i = 0; i < res.size(); ++i) {
+        auto is = variant_istream{from.row(i)};
+        for (auto& var : res[i] = std::vector<variant_t>(from.columns_size()))
+            is >> var;
+    }
+    return res;
+}
+
+/// Writes the snapshot of the rowset to the file
+inline void save_snapshot(const rowset& from, const std::string& file)
+{
+    auto bytes = make_snapshot(from);
+    std::ofstream os{file, std::ios::binary | std::ios::trunc};
+    os.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    if (!os.flush())
+        throw std::runtime_error("failed to write " + file);
+}
+
+/// Snapshot in a read-only memory-mapped file
+class mapped_snapshot {
+public:
+    /// @throw std::runtime_error if the snapshot is inconsistent
+    explicit mapped_snapshot(const std::string& file)
+        : file_{file.c_str(), boost::interprocess::read_only}
+        , region_{file_, boost::interprocess::read_only}
+        , view_{blob_view{static_cast<const std::byte*>(region_.get_address()),
+                          region_.get_size()}}
+    {
+    }
+
+    const snapshot_view& operator*() const { return view_; }
+    const snapshot_view* operator->() const { return &view_; }
+
+private:
+    boost::interprocess::file_mapping file_;
+    boost::interprocess::mapped_region region_;
+    snapshot_view view_;
+};
+
+}  // namespace bark::db
+
+#endif  // BARK_DB_SNAPSHOT_HPP
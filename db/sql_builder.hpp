@@ -5,9 +5,12 @@
 
 #include <bark/db/qualified_name.hpp>
 #include <bark/db/variant.hpp>
-#include <limits>
-#include <locale>
+#include <algorithm>
+#include <charconv>
+#include <iterator>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace bark::db {
@@ -32,6 +35,9 @@ param(T) -> param<T>;
 
 /// Convenient interface for preparing database queries.
 
+/// The text is formatted in place with std::to_chars. Parameter values are
+/// copied to chunks of memory that are never reallocated, so @ref params
+/// refer to them without decoding. @ref clear keeps the memory for reuse.
 /// @code
 /// sql_builder bld = builder(cmd);
 /// bld << "SELECT * FROM " << id("sqlite_master")
@@ -44,40 +50,58 @@ public:
                 sql_parameter_marker parameter_marker)
         : quoted_identifier_{std::move(quoted_identifier)}
         , parameter_marker_{std::move(parameter_marker)}
-        , params_number_{0}
     {
-        sql_.imbue(std::locale::classic());
-        sql_.precision(std::numeric_limits<double>::max_digits10);
     }
 
-    auto sql() const { return sql_.str(); }
+    sql_builder(const sql_builder& other)
+        : quoted_identifier_{other.quoted_identifier_}
+        , parameter_marker_{other.parameter_marker_}
+        , sql_{other.sql_}
+    {
+        for (auto& var : other.params_)
+            push_param(var);
+    }
 
-    auto params() const
+    sql_builder(sql_builder&&) = default;
+    sql_builder& operator=(sql_builder&&) = default;
+
+    sql_builder& operator=(const sql_builder& other)
     {
-        auto res = std::vector<variant_t>{};
-        for (auto is = variant_istream{params_.data}; !is.data.empty();)
-            res.push_back(read(is));
-        return res;
+        return *this = sql_builder{other};
+    }
+
+    /// The view is null-terminated
+    std::string_view sql() const { return sql_; }
+
+    const std::vector<variant_t>& params() const { return params_; }
+
+    /// Discards the text and parameters but keeps the allocated memory
+    void clear()
+    {
+        sql_.clear();
+        params_.clear();
+        for (auto& chunk : chunks_)
+            chunk.clear();
+        chunk_ = 0;
     }
 
     sql_builder& operator<<(std::string_view sql)
     {
-        sql_ << sql;
+        sql_ += sql;
         return *this;
     }
 
     sql_builder& operator<<(const qualified_name& name)
     {
-        sql_ << list{name, ".", quoted_identifier_};
-        return *this;
+        return *this << list{name, ".", quoted_identifier_};
     }
 
     template <class T>
     sql_builder& operator<<(const param<T>& manip)
     {
         if (parameter_marker_) {
-            sql_ << parameter_marker_(params_number_++);
-            params_ << manip.val;
+            sql_ += parameter_marker_(params_.size());
+            push_param(manip.val);
         }
         else
             embed_param(manip.val);
@@ -92,33 +116,102 @@ public:
     }
 
     template <class T>
-    if_arithmetic_t<T, sql_builder&> operator<<(const T& val)
+    if_arithmetic_t<T, sql_builder&> operator<<(T val)
     {
-        sql_ << val;
+        if constexpr (std::is_same_v<T, bool>)
+            sql_ += val ? '1' : '0';
+        else if constexpr (std::is_same_v<T, char> ||
+                           std::is_same_v<T, signed char> ||
+                           std::is_same_v<T, unsigned char>)
+            sql_ += char(val);
+        else if constexpr (std::is_enum_v<T>)
+            *this << std::underlying_type_t<T>(val);
+        else {
+            char buf[32];
+            auto res = std::to_chars(std::begin(buf), std::end(buf), val);
+            sql_.append(buf, res.ptr);
+        }
         return *this;
     }
 
 private:
+    static constexpr size_t ChunkSize = 64 * 1024;
+
     sql_quoted_identifier quoted_identifier_;
     sql_parameter_marker parameter_marker_;
-    std::ostringstream sql_;
-    variant_ostream params_;
-    size_t params_number_;
+    std::string sql_;
+    std::vector<variant_t> params_;
+    std::vector<blob> chunks_;
+    size_t chunk_ = 0;  ///< current
+
+    /// Returns a stable copy
+    blob_view store(blob_view data, size_t padding = 0)
+    {
+        auto size = data.size() + padding;
+        for (; chunk_ < chunks_.size(); ++chunk_) {
+            auto& chunk = chunks_[chunk_];
+            if (chunk.capacity() - chunk.size() >= size)
+                break;
+        }
+        if (chunk_ == chunks_.size())
+            chunks_.emplace_back().reserve(std::max(ChunkSize, size));
+        auto& chunk = chunks_[chunk_];
+        auto pos = chunk.size();
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        chunk.resize(pos + size);  // zero padding
+        return {chunk.data() + pos, data.size()};
+    }
+
+    void push_param(const variant_t& var)
+    {
+        std::visit(
+            overloaded{
+                [&](auto v) { params_.push_back(v); },
+                [&](std::string_view v) {
+                    auto bytes = reinterpret_cast<const std::byte*>(v.data());
+                    auto copy = store({bytes, v.size()}, 1);  // zero terminated
+                    params_.push_back(std::string_view{
+                        reinterpret_cast<const char*>(copy.data()), v.size()});
+                },
+                [&](blob_view v) { params_.push_back(store(v)); }},
+            var);
+    }
+
+    template <class T>
+    if_arithmetic_t<T> push_param(T val)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+            params_.push_back((double)val);
+        else
+            params_.push_back((int64_t)val);
+    }
 
     void embed_param(const variant_t& var)
     {
         std::visit(
-            overloaded{[&](std::monostate) { sql_ << "NULL"; },
-                       [&](auto v) { sql_ << v; },
-                       [&](std::string_view v) { sql_ << "'" << v << "'"; },
-                       [&](blob_view v) { sql_ << "X'" << hex{v} << "'"; }},
+            overloaded{[&](std::monostate) { sql_ += "NULL"; },
+                       [&](auto v) { *this << v; },
+                       [&](std::string_view v) {
+                           sql_ += '\'';
+                           for (auto ch : v) {
+                               if (ch == '\'')
+                                   sql_ += ch;
+                               sql_ += ch;
+                           }
+                           sql_ += '\'';
+                       },
+                       [&](blob_view v) {
+                           sql_ += "X'";
+                           append_hex(sql_, v);
+                           sql_ += '\'';
+                       }},
             var);
     }
 
     template <class T>
     if_arithmetic_t<T> embed_param(T val)
     {
-        sql_ << val;
+        *this << val;
     }
 };
 
@@ -6,7 +6,6 @@
 #include <bark/db/command.hpp>
 #include <bark/db/detail/transaction.hpp>
 #include <bark/db/sqlite/detail/utility.hpp>
-#include <boost/algorithm/string.hpp>
 #include <stdexcept>
 
 namespace bark::db::sqlite {
@@ -39,19 +38,19 @@ public:
     void exec(const sql_builder& bld) override
     {
         auto sql = bld.sql();
-        auto params = bld.params();
-        boost::trim_right(sql);
+        auto& params = bld.params();
+        sql = sql.substr(0, sql.find_last_not_of(" \t\n\r") + 1);
         sqlite3_stmt* stmt = nullptr;
         const char* tail = nullptr;
         check(con_,
               sqlite3_prepare_v2(
-                  con_.get(), sql.c_str(), (int)sql.size(), &stmt, &tail));
+                  con_.get(), sql.data(), (int)sql.size(), &stmt, &tail));
         stmt_.reset(stmt);
-        if (strlen(tail)) {
+        if (tail != sql.data() + sql.size()) {
             stmt_.reset(nullptr);
             if (!params.empty())
                 throw std::runtime_error("SQLite params in multistatement");
-            check(con_, sqlite3_exec(con_.get(), sql.c_str(), 0, 0, 0));
+            check(con_, sqlite3_exec(con_.get(), sql.data(), 0, 0, 0));
         }
         else {
             for (int i = 1; i <= (int)params.size(); ++i) {
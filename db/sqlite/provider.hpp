@@ -39,6 +39,28 @@ public:
             // already init
         }
     }
+
+    /// Returns true if a spatial index would spare scans of a large layer.
+
+    /// Never blocks, false while the layer statistics are unknown.
+    bool spatial_index_advised(const qualified_name& lr_nm)
+    {
+        auto stats = statistics(table(qualifier(lr_nm)), lr_nm.back());
+        return stats && !stats->indexed &&
+               stats->rows >= sqlite_dialect::IndexRows;
+    }
+
+    /// Creates the spatial index, so the next windows use it.
+
+    /// It blocks for a while on a large layer, so it is called off the UI
+    /// thread by a caller that owns the provider, e.g. a task of nanogis.
+    void build_spatial_index(const qualified_name& lr_nm)
+    {
+        auto bld = builder(*this);
+        as_dialect().create_spatial_index_sql(bld, lr_nm, extent(lr_nm));
+        exec(*this, bld);
+        refresh();
+    }
 };
 
 }  // namespace bark::db::sqlite
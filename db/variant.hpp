@@ -44,6 +44,26 @@ inline variant_t read(variant_istream& src)
     throw std::logic_error{"invalid variant"};
 }
 
+/// Moves past a value without decoding it
+inline void skip(variant_istream& src)
+{
+    switch (bark::read<uint8_t>(src.data)) {
+        case variant_index<variant_t, std::monostate>():
+            return;
+        case variant_index<variant_t, int64_t>():
+        case variant_index<variant_t, double>():
+            src.data.remove_prefix(8);
+            return;
+        case variant_index<variant_t, std::string_view>():
+            src.data.remove_prefix(bark::read<size_t>(src.data) + 1);
+            return;
+        case variant_index<variant_t, blob_view>():
+            src.data.remove_prefix(bark::read<size_t>(src.data));
+            return;
+    }
+    throw std::logic_error{"invalid variant"};
+}
+
 inline void write(const variant_t& src, variant_ostream& dest)
 {
     dest.data << static_cast<uint8_t>(src.index());
@@ -0,0 +1,201 @@
+// Andrew Naplavkov
+
+#ifndef BARK_DB_WKB_DECODER_HPP
+#define BARK_DB_WKB_DECODER_HPP
+
+#include <algorithm>
+#include <bark/db/rowset.hpp>
+#include <bark/detail/executor.hpp>
+#include <bark/geometry/geom_from_wkb.hpp>
+#include <bark/geometry/geometry_ops.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace bark::db {
+
+/// Vertices of a geometry column in contiguous buffers
+struct flat_coords {
+    std::vector<double> coords;  ///< x, y pairs
+    std::vector<size_t> offsets;  ///< of every row in coords and their size
+};
+
+/// Threads shared by the decoders
+inline executor& decoding_executor()
+{
+    return shared_executors::instance().get(shared_executors::pool::Decoding);
+}
+
+namespace detail {
+
+/// Calls f(row, wkb) for the rows [first, last)
+template <class Functor>
+void for_each_wkb(const rowset& from,
+                  const std::vector<size_t>& offsets,
+                  size_t col,
+                  size_t first,
+                  size_t last,
+                  Functor f)
+{
+    auto cols = from.columns.size();
+    for (auto row = first; row < last; ++row) {
+        auto is = variant_istream{from.data};
+        is.data.remove_prefix(offsets[row * cols + col]);
+        f(row, std::get<blob_view>(read(is)));
+    }
+}
+
+/// Returns the index of the rowset, builds it in @p buf if it is missing
+inline const std::vector<size_t>& value_offsets(const rowset& from,
+                                                size_t col,
+                                                std::vector<size_t>& buf)
+{
+    if (col >= from.columns.size())
+        throw std::out_of_range("rowset column");
+    if (indexed(from))
+        return from.offsets;
+    append_offsets(from.data, buf);
+    return buf;
+}
+
+}  // namespace detail
+
+/// Decodes the WKB column into geometries in parallel.
+
+/// Rows are split into ranges of @p grain by @ref rowset::offsets, which
+/// are built once if the rowset is not indexed.
+/// @throw std::bad_variant_access on NULL
+inline std::vector<geometry::geometry> decode_geometries(
+    const rowset& from,
+    size_t col,
+    executor& exec = decoding_executor(),
+    size_t grain = 1024)
+{
+    BARK_TRACE_SCOPE("db::decode_geometries");
+    std::vector<size_t> buf;
+    auto& offsets = detail::value_offsets(from, col, buf);
+    std::vector<geometry::geometry> res((offsets.size() - 1) /
+                                        from.columns.size());
+    parallel_for(exec, res.size(), grain, [&](size_t first, size_t last) {
+        detail::for_each_wkb(
+            from, offsets, col, first, last, [&](size_t row, auto wkb) {
+                res[row] = geometry::geom_from_wkb(wkb);
+            });
+    });
+    return res;
+}
+
+/// Decodes vertices of the WKB column into flat buffers in parallel.
+
+/// Every range is decoded into its own buffer, which are then
+/// concatenated in order.
+/// @throw std::bad_variant_access on NULL
+inline flat_coords decode_coords(const rowset& from,
+                                 size_t col,
+                                 executor& exec = decoding_executor(),
+                                 size_t grain = 1024)
+{
+    BARK_TRACE_SCOPE("db::decode_coords");
+    std::vector<size_t> buf;
+    auto& offsets = detail::value_offsets(from, col, buf);
+    auto rows = (offsets.size() - 1) / from.columns.size();
+    grain = std::max<size_t>(1, grain);
+    std::vector<flat_coords> parts((rows + grain - 1) / grain);
+    parallel_for(exec, rows, grain, [&](size_t first, size_t last) {
+        auto& part = parts[first / grain];
+        detail::for_each_wkb(
+            from, offsets, col, first, last, [&](size_t, auto wkb) {
+                part.offsets.push_back(part.coords.size());
+                geometry::coords_from_wkb(wkb, part.coords);
+            });
+    });
+
+    flat_coords res;
+    if (parts.size() == 1)
+        res = std::move(parts.front());
+    if (parts.size() <= 1) {
+        res.offsets.push_back(res.coords.size());
+        return res;
+    }
+    size_t coords = 0;
+    for (auto& part : parts)
+        coords += part.coords.size();
+    res.coords.reserve(coords);
+    res.offsets.reserve(rows + 1);
+    for (auto& part : parts) {
+        auto base = res.coords.size();
+        for (auto pos : part.offsets)
+            res.offsets.push_back(base + pos);
+        res.coords.insert(
+            res.coords.end(), part.coords.begin(), part.coords.end());
+    }
+    res.offsets.push_back(res.coords.size());
+    return res;
+}
+
+/// Packs envelopes of the features of the WKB column into an R-tree.
+
+/// Values are row numbers, NULL and empty geometries are skipped.
+inline geometry::numbered_box_rtree make_feature_index(const rowset& from,
+                                                       size_t col)
+{
+    BARK_TRACE_SCOPE("db::make_feature_index");
+    std::vector<size_t> buf;
+    auto& offsets = detail::value_offsets(from, col, buf);
+    auto rows = (offsets.size() - 1) / from.columns.size();
+    std::vector<geometry::numbered_box> boxes;
+    boxes.reserve(rows);
+    std::vector<double> coords;
+    for (size_t row = 0; row < rows; ++row) {
+        auto is = variant_istream{from.data};
+        is.data.remove_prefix(offsets[row * from.columns.size() + col]);
+        auto var = read(is);
+        auto wkb = std::get_if<blob_view>(&var);
+        if (!wkb)
+            continue;
+        coords.clear();
+        geometry::coords_from_wkb(*wkb, coords);
+        if (coords.empty())
+            continue;
+        geometry::box bbox{{coords[0], coords[1]}, {coords[0], coords[1]}};
+        for (size_t i = 2; i < coords.size(); i += 2)
+            boost::geometry::expand(bbox,
+                                    geometry::point{coords[i], coords[i + 1]});
+        boxes.emplace_back(bbox, row);
+    }
+    return {boxes.begin(), boxes.end()};  // packing algorithm
+}
+
+/// Selects the rows with geometries of the WKB column that intersect the
+/// box exactly, NULL geometries are skipped.
+inline rowset intersecting_rows(const rowset& from,
+                                size_t col,
+                                const geometry::box& bbox)
+{
+    BARK_TRACE_SCOPE("db::intersecting_rows");
+    std::vector<size_t> buf;
+    auto& offsets = detail::value_offsets(from, col, buf);
+    auto cols = from.columns.size();
+    auto rows = (offsets.size() - 1) / cols;
+    rowset res{from.columns, {}};
+    res.offsets.push_back(0);
+    for (size_t row = 0; row < rows; ++row) {
+        auto is = variant_istream{from.data};
+        is.data.remove_prefix(offsets[row * cols + col]);
+        auto var = read(is);
+        auto wkb = std::get_if<blob_view>(&var);
+        if (!wkb || !geometry::intersects(geometry::geom_from_wkb(*wkb), bbox))
+            continue;
+        auto first = offsets[row * cols];
+        for (size_t i = 1; i <= cols; ++i)
+            res.offsets.push_back(res.data.size() + offsets[row * cols + i] -
+                                  first);
+        res.data.insert(res.data.end(),
+                        from.data.begin() + first,
+                        from.data.begin() + offsets[(row + 1) * cols]);
+    }
+    return res;
+}
+
+}  // namespace bark::db
+
+#endif  // BARK_DB_WKB_DECODER_HPP
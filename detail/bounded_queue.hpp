@@ -0,0 +1,72 @@
+// Andrew Naplavkov
+
+#ifndef BARK_BOUNDED_QUEUE_HPP
+#define BARK_BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace bark {
+
+/// Blocking FIFO of limited capacity to connect pipeline stages.
+
+/// Producers wait while it is full, consumers wait while it is empty.
+/// Closing releases all of them.
+template <class T>
+class bounded_queue {
+public:
+    explicit bounded_queue(size_t capacity) : capacity_{capacity} {}
+
+    /// Returns false if the queue is closed
+    bool push(T val)
+    {
+        auto lock = std::unique_lock{guard_};
+        not_full_.wait(lock,
+                       [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_)
+            return false;
+        items_.push_back(std::move(val));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /// Returns nothing if the queue is closed and drained
+    std::optional<T> pop()
+    {
+        auto lock = std::unique_lock{guard_};
+        not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty())
+            return std::nullopt;
+        auto res = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return res;
+    }
+
+    /// Rejects new items, the remaining ones can still be popped
+    void close()
+    {
+        {
+            auto lock = std::lock_guard{guard_};
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::mutex guard_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+}  // namespace bark
+
+#endif  // BARK_BOUNDED_QUEUE_HPP
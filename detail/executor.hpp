@@ -0,0 +1,293 @@
+// Andrew Naplavkov
+
+#ifndef BARK_EXECUTOR_HPP
+#define BARK_EXECUTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bark {
+
+/// Shared flag to drop all queued tasks of a job at once
+using cancel_token = std::shared_ptr<std::atomic_bool>;
+
+inline cancel_token make_cancel_token()
+{
+    return std::make_shared<std::atomic_bool>(false);
+}
+
+/// Fixed-size thread pool with work stealing.
+
+/// Every worker has its own queue. Tasks submitted from a worker go to its
+/// queue, others are distributed round-robin. A worker takes tasks from its
+/// queue first and steals from the others when it runs dry. Tasks are taken
+/// in the order of submission, so it acts as a priority.
+/// Tasks of a canceled job are dropped without running when dequeued, so
+/// cancellation is a single store and does not wait for the queues.
+class executor {
+public:
+    using task_type = std::function<void()>;
+
+    explicit executor(unsigned threads = std::thread::hardware_concurrency())
+    {
+        threads = std::max(1u, threads);
+        for (unsigned i = 0; i < threads; ++i)
+            queues_.push_back(std::make_unique<queue>());
+        for (unsigned i = 0; i < threads; ++i)
+            threads_.emplace_back([this, i] { work(i); });
+    }
+
+    ~executor() { shutdown(); }
+
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    unsigned concurrency() const { return (unsigned)threads_.size(); }
+
+    /// Drops queued tasks and waits for the running ones.
+
+    /// Tasks submitted later are dropped. It is not called concurrently or
+    /// from the workers of this executor.
+    void shutdown()
+    {
+        {
+            auto lock = std::lock_guard{guard_};
+            stopped_ = true;
+        }
+        notifier_.notify_all();
+        for (auto& thread : threads_)
+            if (thread.joinable())
+                thread.join();
+    }
+
+    /// Uncaught exceptions of the task are reported to std::cerr
+    void submit(task_type f, cancel_token tok = {})
+    {
+        {
+            auto lock = std::lock_guard{guard_};
+            if (stopped_)
+                return;
+        }
+        auto pos = current_ == this ? current_pos_
+                                    : next_pos_++ % queues_.size();
+        {
+            auto& q = *queues_[pos];
+            auto lock = std::lock_guard{q.guard};
+            q.items.push_back({std::move(f), std::move(tok)});
+        }
+        {
+            auto lock = std::lock_guard{guard_};
+            ++pending_;
+        }
+        notifier_.notify_one();
+    }
+
+private:
+    struct item {
+        task_type f;
+        cancel_token tok;
+    };
+
+    struct queue {
+        std::mutex guard;
+        std::deque<item> items;
+    };
+
+    inline static thread_local executor* current_ = nullptr;
+    inline static thread_local size_t current_pos_ = 0;
+
+    std::vector<std::unique_ptr<queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_pos_{0};
+    std::mutex guard_;
+    std::condition_variable notifier_;
+    size_t pending_ = 0;
+    bool stopped_ = false;
+
+    std::optional<item> take(size_t pos)
+    {
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            auto& q = *queues_[(pos + i) % queues_.size()];
+            auto lock = std::lock_guard{q.guard};
+            if (q.items.empty())
+                continue;
+            auto res = std::move(q.items.front());
+            q.items.pop_front();
+            return res;
+        }
+        return std::nullopt;
+    }
+
+    void work(size_t pos)
+    {
+        current_ = this;
+        current_pos_ = pos;
+        for (;;) {
+            {
+                auto lock = std::unique_lock{guard_};
+                notifier_.wait(lock, [&] { return stopped_ || pending_; });
+                if (stopped_)
+                    return;
+                --pending_;
+            }
+            // reserved task may be pushed to a queue that was already passed
+            auto it = take(pos);
+            for (; !it; it = take(pos))
+                std::this_thread::yield();
+            if (it->tok && *it->tok)
+                continue;
+            try {
+                it->f();
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+    }
+};
+
+/// Thread pools shared by the library, created on first use.
+
+/// One object owns them, so an application stops them all with shutdown()
+/// while the objects their tasks refer to are alive, e.g. at the end of
+/// main() before QApplication is destroyed. Otherwise they stop with the
+/// other statics.
+class shared_executors {
+public:
+    /// In the order of shutdown, loading submits painting
+    enum class pool { Linking, Loading, Painting, Background, Decoding };
+
+    static shared_executors& instance()
+    {
+        static shared_executors res;
+        return res;
+    }
+
+    /// A pool requested after shutdown() is stopped at once
+    executor& get(pool id)
+    {
+        auto lock = std::lock_guard{guard_};
+        auto& res = pools_[size_t(id)];
+        if (!res) {
+            res = std::make_unique<executor>(threads(id));
+            if (stopped_)
+                res->shutdown();
+        }
+        return *res;
+    }
+
+    /// Drops queued tasks and waits for the running ones
+    void shutdown()
+    {
+        std::vector<executor*> pools;
+        {
+            auto lock = std::lock_guard{guard_};
+            if (std::exchange(stopped_, true))
+                return;
+            for (auto& ptr : pools_)
+                if (ptr)
+                    pools.push_back(ptr.get());
+        }
+        // running tasks may request pools, so the lock is not held
+        for (auto ptr : pools)
+            ptr->shutdown();
+    }
+
+private:
+    std::mutex guard_;
+    std::unique_ptr<executor> pools_[5];
+    bool stopped_ = false;
+
+    shared_executors() = default;
+
+    static unsigned threads(pool id)
+    {
+        auto hw = std::thread::hardware_concurrency();
+        switch (id) {
+            case pool::Linking:
+                return 4;
+            case pool::Loading:
+                return 2 * hw;
+            case pool::Background:
+                return 2;
+            default:
+                return hw;
+        }
+    }
+};
+
+/// Calls f(first, last) for consecutive ranges of [0, size) no longer than
+/// grain. Ranges are taken by the calling thread and the workers of the
+/// executor, so it does not deadlock if the workers are busy. Returns when
+/// all ranges are done and rethrows the first exception.
+template <class Functor>
+void parallel_for(executor& exec, size_t size, size_t grain, Functor f)
+{
+    struct state {
+        Functor f;
+        size_t size;
+        size_t grain;
+        size_t ranges;
+        std::atomic<size_t> next{0};
+        std::mutex guard;
+        std::condition_variable notifier;
+        size_t done = 0;
+        std::exception_ptr error;
+
+        state(Functor&& f, size_t size, size_t grain)
+            : f{std::move(f)}
+            , size{size}
+            , grain{grain}
+            , ranges{(size + grain - 1) / grain}
+        {
+        }
+
+        /// Takes ranges until none are left
+        void work()
+        {
+            for (size_t idx; (idx = next++) < ranges;) {
+                std::exception_ptr err;
+                try {
+                    auto first = idx * grain;
+                    f(first, std::min(size, first + grain));
+                }
+                catch (...) {
+                    err = std::current_exception();
+                }
+                auto lock = std::lock_guard{guard};
+                if (err && !error)
+                    error = err;
+                if (++done == ranges)
+                    notifier.notify_all();
+            }
+        }
+    };
+
+    if (!size)
+        return;
+    auto st =
+        std::make_shared<state>(std::move(f), size, std::max<size_t>(1, grain));
+    auto helpers = std::min<size_t>(exec.concurrency(), st->ranges - 1);
+    for (size_t i = 0; i < helpers; ++i)
+        exec.submit([st] { st->work(); });
+    st->work();
+    auto lock = std::unique_lock{st->guard};
+    st->notifier.wait(lock, [&] { return st->done == st->ranges; });
+    if (st->error)
+        std::rethrow_exception(st->error);
+}
+
+}  // namespace bark
+
+#endif  // BARK_EXECUTOR_HPP
@@ -0,0 +1,62 @@
+// Andrew Naplavkov
+
+#ifndef BARK_LOCK_FREE_STACK_HPP
+#define BARK_LOCK_FREE_STACK_HPP
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace bark {
+
+/// Multiple producers push items, a consumer takes them all at once.
+
+/// Items are never popped one by one, so the stack is free of ABA problem.
+template <class T>
+class lock_free_stack {
+public:
+    lock_free_stack() = default;
+    lock_free_stack(const lock_free_stack&) = delete;
+    lock_free_stack& operator=(const lock_free_stack&) = delete;
+
+    ~lock_free_stack() { release(head_.exchange(nullptr)); }
+
+    void push(T val)
+    {
+        auto item = new node{std::move(val), head_.load()};
+        while (!head_.compare_exchange_weak(item->next, item))
+            ;
+    }
+
+    bool empty() const { return !head_.load(); }
+
+    /// Returns items in the order of pushing
+    std::vector<T> pop_all()
+    {
+        std::vector<T> res;
+        auto head = head_.exchange(nullptr);
+        for (auto item = head; item; item = item->next)
+            res.push_back(std::move(item->val));
+        release(head);
+        return {std::make_move_iterator(res.rbegin()),
+                std::make_move_iterator(res.rend())};
+    }
+
+private:
+    struct node {
+        T val;
+        node* next;
+    };
+
+    std::atomic<node*> head_{nullptr};
+
+    static void release(node* item)
+    {
+        while (item)
+            delete std::exchange(item, item->next);
+    }
+};
+
+}  // namespace bark
+
+#endif  // BARK_LOCK_FREE_STACK_HPP
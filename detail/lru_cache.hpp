@@ -6,6 +6,7 @@
 #include <atomic>
 #include <bark/detail/any_hashable.hpp>
 #include <bark/detail/linked_hash_map.hpp>
+#include <bark/detail/trace.hpp>
 #include <bark/detail/utility.hpp>
 #include <optional>
 
@@ -37,13 +38,19 @@ public:
         auto scoped_key = key_type{std::make_pair(scope, key)};
         auto guard = timed_lockable<key_type, hash_type>{scoped_key};
         auto lock = std::unique_lock{guard, std::defer_lock};
-        if (!lock.try_lock_for(Timeout))
+        if (!lock.try_lock_for(Timeout)) {
+            BARK_TRACE_COUNTER("lru_cache::busy", 1);
             throw busy_exception{};
-        if (auto opt = at(scoped_key))
+        }
+        if (auto opt = at(scoped_key)) {
+            BARK_TRACE_COUNTER("lru_cache::hits", 1);
             return std::move(opt).value().get();
+        }
+        BARK_TRACE_COUNTER("lru_cache::misses", 1);
         auto res = mapped_type::result_of(std::forward<F>(f),
                                           std::forward<Args>(args)...);
-        insert({scoped_key, res});
+        if (!res.template holds_exception<busy_exception>())  // transient
+            insert({scoped_key, res});
         return std::move(res).get();
     }
 
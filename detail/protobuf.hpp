@@ -0,0 +1,95 @@
+// Andrew Naplavkov
+
+#ifndef BARK_PROTOBUF_HPP
+#define BARK_PROTOBUF_HPP
+
+#include <bark/blob.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace bark::protobuf {
+
+/// @see https://developers.google.com/protocol-buffers/docs/encoding
+enum class wire_type : uint32_t { Varint = 0, Fixed64 = 1, Length = 2 };
+
+constexpr uint32_t zigzag(int32_t val)
+{
+    return (static_cast<uint32_t>(val) << 1) ^ static_cast<uint32_t>(val >> 31);
+}
+
+constexpr uint64_t zigzag(int64_t val)
+{
+    return (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+}
+
+inline void write_varint(uint64_t val, blob& dest)
+{
+    for (; val >= 0x80; val >>= 7)
+        dest.push_back(static_cast<std::byte>(val | 0x80));
+    dest.push_back(static_cast<std::byte>(val));
+}
+
+/// Serializes fields of a message (little-endian host is assumed)
+struct ostream {
+    blob data;
+
+    ostream& key(uint32_t field, wire_type type)
+    {
+        write_varint(field << 3 | static_cast<uint32_t>(type), data);
+        return *this;
+    }
+
+    ostream& varint(uint32_t field, uint64_t val)
+    {
+        key(field, wire_type::Varint);
+        write_varint(val, data);
+        return *this;
+    }
+
+    ostream& fixed64(uint32_t field, double val)
+    {
+        key(field, wire_type::Fixed64);
+        std::byte bytes[sizeof val];
+        std::memcpy(bytes, &val, sizeof val);
+        data.insert(data.end(), std::begin(bytes), std::end(bytes));
+        return *this;
+    }
+
+    ostream& bytes(uint32_t field, blob_view val)
+    {
+        key(field, wire_type::Length);
+        write_varint(val.size(), data);
+        data.insert(data.end(), val.begin(), val.end());
+        return *this;
+    }
+
+    ostream& bytes(uint32_t field, std::string_view val)
+    {
+        return bytes(field, blob_view{as_bytes(val), val.size()});
+    }
+
+    ostream& message(uint32_t field, const ostream& val)
+    {
+        return bytes(field, blob_view{val.data});
+    }
+
+    template <class Range>
+    ostream& packed(uint32_t field, const Range& vals)
+    {
+        blob buf;
+        for (auto val : vals)
+            write_varint(val, buf);
+        return bytes(field, blob_view{buf});
+    }
+
+private:
+    static const std::byte* as_bytes(std::string_view val)
+    {
+        return reinterpret_cast<const std::byte*>(val.data());
+    }
+};
+
+}  // namespace bark::protobuf
+
+#endif  // BARK_PROTOBUF_HPP
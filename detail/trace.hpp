@@ -0,0 +1,421 @@
+// Andrew Naplavkov
+
+#ifndef BARK_TRACE_HPP
+#define BARK_TRACE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Low-overhead instrumentation of hot paths.
+
+/// Compiled out unless BARK_TRACE is defined.
+/// Every thread keeps its own statistics of a call site, so the hot path
+/// takes no locks and shares no cache lines. Events are recorded to bounded
+/// thread-local buffers between trace::start() and trace::stop().
+/// @code
+/// void fetch()
+/// {
+///     BARK_TRACE_SCOPE("db::fetch");
+///     BARK_TRACE_COUNTER("db::fetched_bytes", bytes);
+/// }
+/// @endcode
+#ifdef BARK_TRACE
+#define BARK_TRACE_SCOPE(name) BARK_TRACE_SCOPE_LINE(name, __LINE__)
+#define BARK_TRACE_SCOPE_LINE(name, line) BARK_TRACE_SCOPE_IMPL(name, line)
+#define BARK_TRACE_SCOPE_IMPL(name, line)                    \
+    static ::bark::trace::site bark_trace_site_##line{name}; \
+    ::bark::trace::scope bark_trace_scope_##line{bark_trace_site_##line}
+#define BARK_TRACE_COUNTER(name, delta)                   \
+    do {                                                  \
+        static ::bark::trace::site bark_trace_site{name}; \
+        bark_trace_site.add(delta);                       \
+    } while (false)
+#else
+#define BARK_TRACE_SCOPE(name) static_cast<void>(0)
+#define BARK_TRACE_COUNTER(name, delta) static_cast<void>(0)
+#endif
+
+namespace bark::trace {
+
+using clock = std::chrono::steady_clock;
+
+struct stat {
+    std::string name;
+    uint64_t count = 0;  ///< calls of a scope or sum of a counter
+    std::chrono::nanoseconds total{};
+    std::chrono::nanoseconds max{};
+};
+
+namespace detail {
+
+enum class phase : char { Complete = 'X', Counter = 'C' };
+
+struct event {
+    const char* name;
+    phase ph;
+    int64_t ts;  ///< nanoseconds since epoch of the clock
+    int64_t val;  ///< duration or counter value
+};
+
+/// Written by the owner thread, read by exporters
+struct chunk {
+    static constexpr size_t Capacity = 4096;
+    std::array<event, Capacity> events;
+    std::atomic<size_t> size{0};
+    std::atomic<chunk*> next{nullptr};
+};
+
+/// Statistics of a site in a thread, written by the owner thread only
+struct counters {
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t> total{0};
+    std::atomic<int64_t> max{0};
+
+    void add(uint64_t delta)
+    {
+        count.store(count.load(std::memory_order_relaxed) + delta,
+                    std::memory_order_relaxed);
+    }
+
+    void add_time(int64_t dur)
+    {
+        add(1);
+        total.store(total.load(std::memory_order_relaxed) + dur,
+                    std::memory_order_relaxed);
+        if (max.load(std::memory_order_relaxed) < dur)
+            max.store(dur, std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        count = 0;
+        total = 0;
+        max = 0;
+    }
+};
+
+class thread_buffer {
+public:
+    static constexpr size_t BlockSize = 64;
+    static constexpr size_t MaxSites = BlockSize * BlockSize;
+    static constexpr size_t MaxChunks = 64;  ///< events beyond are dropped
+
+    const int tid;
+
+    explicit thread_buffer(int id) : tid{id}, tail_{&head_} {}
+
+    ~thread_buffer()
+    {
+        clear_chunks();
+        for (auto& block : blocks_)
+            delete block.load();
+    }
+
+    /// Owner thread only, nullptr if there are too many sites
+    counters* at(size_t site_id)
+    {
+        if (site_id >= MaxSites)
+            return nullptr;
+        auto& block = blocks_[site_id / BlockSize];
+        auto ptr = block.load(std::memory_order_relaxed);
+        if (!ptr) {
+            ptr = new counters_block;
+            block.store(ptr, std::memory_order_release);
+        }
+        return &(*ptr)[site_id % BlockSize];
+    }
+
+    /// Any thread, nullptr if the owner has not used the site
+    const counters* find(size_t site_id) const
+    {
+        if (site_id >= MaxSites)
+            return nullptr;
+        auto ptr =
+            blocks_[site_id / BlockSize].load(std::memory_order_acquire);
+        return ptr ? &(*ptr)[site_id % BlockSize] : nullptr;
+    }
+
+    void push(const event& ev)
+    {
+        auto pos = tail_->size.load(std::memory_order_relaxed);
+        if (pos == chunk::Capacity) {
+            if (chunks_ == MaxChunks) {
+                dropped_.store(dropped_.load(std::memory_order_relaxed) + 1,
+                               std::memory_order_relaxed);
+                return;
+            }
+            auto next = new chunk;
+            tail_->next.store(next, std::memory_order_release);
+            tail_ = next;
+            ++chunks_;
+            pos = 0;
+        }
+        tail_->events[pos] = ev;
+        tail_->size.store(pos + 1, std::memory_order_release);
+    }
+
+    template <class Functor>
+    void for_each(Functor f) const
+    {
+        for (auto it = &head_; it; it = it->next.load()) {
+            auto size = it->size.load(std::memory_order_acquire);
+            std::for_each_n(it->events.begin(), size, f);
+        }
+    }
+
+    uint64_t dropped() const { return dropped_; }
+
+    /// Neither the owner nor exporters may run concurrently
+    void clear()
+    {
+        clear_chunks();
+        for (auto& block : blocks_)
+            if (auto ptr = block.load())
+                for (auto& cnt : *ptr)
+                    cnt.clear();
+        dropped_ = 0;
+    }
+
+private:
+    using counters_block = std::array<counters, BlockSize>;
+
+    chunk head_;
+    chunk* tail_;
+    size_t chunks_ = 1;
+    std::atomic<uint64_t> dropped_{0};
+    std::array<std::atomic<counters_block*>, BlockSize> blocks_{};
+
+    void clear_chunks()
+    {
+        for (auto it = head_.next.exchange(nullptr); it;)
+            delete std::exchange(it, it->next.load());
+        head_.size = 0;
+        tail_ = &head_;
+        chunks_ = 1;
+    }
+};
+
+struct site_base;
+
+struct registry {
+    std::atomic<bool> recording{false};
+    std::atomic<site_base*> sites{nullptr};
+    std::atomic<size_t> site_ids{0};
+    std::mutex guard;  ///< taken once per thread
+    std::vector<std::shared_ptr<thread_buffer>> buffers;
+    int tids = 0;
+
+    static registry& instance()
+    {
+        static registry res;
+        return res;
+    }
+
+    thread_buffer& local()
+    {
+        thread_local auto res = [this] {
+            auto lock = std::lock_guard{guard};
+            return buffers.emplace_back(
+                std::make_shared<thread_buffer>(++tids));
+        }();
+        return *res;
+    }
+
+    std::vector<std::shared_ptr<thread_buffer>> copy_buffers()
+    {
+        auto lock = std::lock_guard{guard};
+        return buffers;
+    }
+};
+
+struct site_base {
+    const char* const name;
+    const size_t id;
+    site_base* next = nullptr;
+
+    explicit site_base(const char* nm)
+        : name{nm}, id{registry::instance().site_ids++}
+    {
+        auto& reg = registry::instance();
+        next = reg.sites.load();
+        while (!reg.sites.compare_exchange_weak(next, this))
+            ;
+    }
+};
+
+inline int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               clock::now().time_since_epoch())
+        .count();
+}
+
+inline void escape(std::ostream& os, const char* str)
+{
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\')
+            os << '\\';
+        os << *str;
+    }
+}
+
+}  // namespace detail
+
+/// Call site, registered on construction
+class site : public detail::site_base {
+public:
+    using site_base::site_base;
+
+    void add(int64_t delta)
+    {
+        auto& reg = detail::registry::instance();
+        auto& buf = reg.local();
+        auto cnt = buf.at(id);
+        if (!cnt)
+            return;
+        cnt->add(delta);
+        if (reg.recording.load(std::memory_order_relaxed))
+            buf.push({name,
+                      detail::phase::Counter,
+                      detail::now(),
+                      int64_t(cnt->count.load(std::memory_order_relaxed))});
+    }
+
+    void add(std::chrono::nanoseconds dur, int64_t first)
+    {
+        auto& reg = detail::registry::instance();
+        auto& buf = reg.local();
+        auto cnt = buf.at(id);
+        if (!cnt)
+            return;
+        cnt->add_time(dur.count());
+        if (reg.recording.load(std::memory_order_relaxed))
+            buf.push({name, detail::phase::Complete, first, dur.count()});
+    }
+};
+
+/// Measures the lifetime of the object
+class scope {
+public:
+    explicit scope(site& st) : site_{st}, first_{detail::now()} {}
+    ~scope()
+    {
+        site_.add(std::chrono::nanoseconds{detail::now() - first_}, first_);
+    }
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+private:
+    site& site_;
+    const int64_t first_;
+};
+
+/// Starts recording of events for @ref write_chrome_json
+inline void start()
+{
+    detail::registry::instance().recording = true;
+}
+
+inline void stop()
+{
+    detail::registry::instance().recording = false;
+}
+
+/// Discards the statistics and recorded events.
+
+/// Call it after stop(), while the traced threads are idle. Buffers of the
+/// finished threads are released.
+inline void reset()
+{
+    auto& reg = detail::registry::instance();
+    auto lock = std::lock_guard{reg.guard};
+    reg.buffers.erase(std::remove_if(reg.buffers.begin(),
+                                     reg.buffers.end(),
+                                     [](auto& buf) {
+                                         return buf.use_count() == 1;
+                                     }),
+                      reg.buffers.end());
+    for (auto& buf : reg.buffers)
+        buf->clear();
+}
+
+/// Returns the number of events that did not fit the buffers
+inline uint64_t dropped()
+{
+    uint64_t res = 0;
+    for (auto& buf : detail::registry::instance().copy_buffers())
+        res += buf->dropped();
+    return res;
+}
+
+/// Returns statistics of the sites merged by name
+inline std::vector<stat> snapshot()
+{
+    auto& reg = detail::registry::instance();
+    auto buffers = reg.copy_buffers();
+    std::map<std::string, stat> merged;
+    for (auto it = reg.sites.load(); it; it = it->next) {
+        auto& res = merged[it->name];
+        res.name = it->name;
+        for (auto& buf : buffers)
+            if (auto cnt = buf->find(it->id)) {
+                res.count += cnt->count;
+                res.total += std::chrono::nanoseconds{cnt->total};
+                res.max =
+                    std::max(res.max, std::chrono::nanoseconds{cnt->max});
+            }
+    }
+    std::vector<stat> res;
+    for (auto& [name, val] : merged)
+        res.push_back(std::move(val));
+    return res;
+}
+
+/// Writes recorded events in the Trace Event Format
+/// @see chrome://tracing or https://ui.perfetto.dev
+inline void write_chrome_json(std::ostream& os)
+{
+    auto buffers = detail::registry::instance().copy_buffers();
+    auto sep = "";
+    auto flags = os.flags();
+    auto precision = os.precision();
+    os << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    for (auto& buf : buffers)
+        buf->for_each([&](const detail::event& ev) {
+            os << sep << "{\"name\":\"";
+            detail::escape(os, ev.name);
+            os << "\",\"ph\":\"" << char(ev.ph) << "\",\"pid\":1,\"tid\":"
+               << buf->tid << ",\"ts\":" << ev.ts / 1000.;
+            if (ev.ph == detail::phase::Complete)
+                os << ",\"dur\":" << ev.val / 1000.;
+            else
+                os << ",\"args\":{\"value\":" << ev.val << "}";
+            os << "}";
+            sep = ",";
+        });
+    os << "]}";
+    os.flags(flags);
+    os.precision(precision);
+}
+
+inline std::ostream& operator<<(std::ostream& os, const stat& that)
+{
+    return os << that.name << ": count " << that.count << ", total "
+              << that.total.count() / 1e6 << "ms, max "
+              << that.max.count() / 1e6 << "ms";
+}
+
+}  // namespace bark::trace
+
+#endif  // BARK_TRACE_HPP
@@ -150,6 +150,29 @@ public:
         return res;
     }
 
+    /// Checks whether the creation is prevented by an exception of type E
+    template <class E>
+    bool holds_exception() const
+    {
+        if (auto e = std::get_if<std::exception_ptr>(&val_))
+            try {
+                std::rethrow_exception(*e);
+            }
+            catch (const E&) {
+                return true;
+            }
+            catch (...) {
+            }
+        return false;
+    }
+
+    const T& get() const&
+    {
+        if (auto e = std::get_if<std::exception_ptr>(&val_))
+            std::rethrow_exception(*e);
+        return std::get<T>(val_);
+    }
+
     T get() &&
     {
         return std::visit(
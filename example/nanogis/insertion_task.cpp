@@ -1,17 +1,15 @@
 // Andrew Naplavkov
 
 #include "insertion_task.h"
-#include <QElapsedTimer>
+#include <bark/db/copier.hpp>
 #include <bark/proj/transformer.hpp>
 #include <bark/qt/common_ops.hpp>
 #include <boost/range/adaptor/map.hpp>
-#include <boost/range/adaptor/sliced.hpp>
+#include <memory>
 
 namespace {
 
-const size_t MaxRowNumber = 1000000;
-const size_t MaxVariableNumber = 999;  // @see https://sqlite.org/limits.html
-const qint64 TimeoutMs = 3000;
+const unsigned ReaderNumber = 4;
 
 auto column_map(const bark::qt::layer& lr)
 {
@@ -21,51 +19,6 @@ auto column_map(const bark::qt::layer& lr)
     return res;
 }
 
-template <class RandomAccessRng, class Functor>
-void for_each_slice(const RandomAccessRng& rng, size_t slice_size, Functor f)
-{
-    for (size_t pos = 0, sz = std::size(rng); pos < sz;) {
-        auto prev = pos;
-        pos += std::min(sz - pos, slice_size);
-        f(boost::adaptors::slice(rng, prev, pos));
-    }
-}
-
-class inserter {
-public:
-    inserter(task& tsk, bark::qt::layer lr)
-        : tsk_{tsk}, lr_{std::move(lr)}, cmd_{lr_.provider->make_command()}
-    {
-        cmd_->set_autocommit(false);
-        timer_.start();
-    }
-
-    size_t affected() const { return affected_; }
-
-    template <class ColumnNames, class Rows>
-    void operator()(const ColumnNames& cols, const Rows& rows)
-    {
-        cmd_->exec(insert_sql(*lr_.provider, qualifier(lr_.name), cols, rows));
-        affected_ += std::size(rows);
-    }
-
-    void commit(bool force)
-    {
-        if (force || timer_.elapsed() >= TimeoutMs) {
-            cmd_->commit();
-            tsk_.push_output(QString("affected: %1").arg(affected_));
-            timer_.start();
-        }
-    };
-
-private:
-    task& tsk_;
-    bark::qt::layer lr_;
-    bark::db::command_holder cmd_;
-    size_t affected_ = 0;
-    QElapsedTimer timer_;
-};
-
 }  // anonymous namespace
 
 insertion_task::insertion_task(QVector<bark::qt::layer> from,
@@ -116,28 +69,35 @@ void insertion_task::insert(const bark::qt::layer& from,
                             const bark::qt::layer& to,
                             string_map cols)
 {
+    using namespace bark::db;
     cols.insert({from.name.back(), to.name.back()});
     auto geom_pos = std::distance(cols.begin(), cols.find(from.name.back()));
-    auto limit = std::max<size_t>(1, MaxVariableNumber / cols.size());
-    auto tf = bark::proj::transformer{projection(from), projection(to)};
-    auto insert = inserter{*this, to};
-    while (true) {
-        auto rowset = fetch_all(*from.provider,
-                                select_sql(*from.provider,
-                                           qualifier(from.name),
-                                           insert.affected(),
-                                           MaxRowNumber));
-        auto rows = select(cols | boost::adaptors::map_keys, rowset);
-        for_each_slice(rows, limit, [&](auto&& slice) {
-            if (!tf.is_trivial())
-                bark::db::for_each_blob(slice, geom_pos, tf.inplace_forward());
-            insert(cols | boost::adaptors::map_values, slice);
-            insert.commit(/*force*/ false);
-        });
-        if (rows.size() < MaxRowNumber)
-            break;
-    }
-    insert.commit(/*force*/ true);
+    auto from_proj = projection(from);
+    auto to_proj = projection(to);
+    copying_options opts;
+    opts.readers = ReaderNumber;
+    opts.serial = from.uri == to.uri;
+    if (from_proj != to_proj)
+        opts.transform = [=] {
+            auto tf = std::make_shared<bark::proj::transformer>(from_proj,
+                                                                to_proj);
+            return [=](std::vector<std::vector<variant_t>>& rows) {
+                for_each_blob(rows, geom_pos, tf->inplace_forward());
+            };
+        };
+    opts.progress = [this](size_t rows) {
+        push_output(QString("affected: %1").arg(rows));
+    };
+    auto stats = copy_table(*from.provider,
+                            qualifier(from.name),
+                            bark::as<std::vector<std::string>>(
+                                cols | boost::adaptors::map_keys),
+                            *to.provider,
+                            qualifier(to.name),
+                            bark::as<std::vector<std::string>>(
+                                cols | boost::adaptors::map_values),
+                            opts);
+    ::push_output(*this, bark::concat(stats));
     to.provider->refresh();
 }
 
@@ -1,10 +1,14 @@
 ﻿#include <QApplication>
 #include "main_window.h"
+#include <bark/detail/executor.hpp>
 
 int main(int argc, char* argv[])
 {
     QApplication a(argc, argv);
     main_window w;
     w.show();
-    return a.exec();
+    auto res = a.exec();
+    // tasks refer to widgets, so they are stopped before them
+    bark::shared_executors::instance().shutdown();
+    return res;
 }
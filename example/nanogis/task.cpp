@@ -2,6 +2,7 @@
 
 #include "task.h"
 #include <QThreadPool>
+#include <bark/db/sqlite/provider.hpp>
 #include <bark/geometry/envelope.hpp>
 #include <bark/geometry/geom_from_wkb.hpp>
 #include <bark/proj/transformer.hpp>
@@ -119,12 +120,28 @@ void deletion_task::run_event()
 {
     push_output(lr_.uri.toDisplayString(QUrl::DecodeReserved));
     auto query = drop_sql(*lr_.provider, qualifier(lr_.name));
-    ::push_output(*this, query.sql());
+    ::push_output(*this, std::string{query.sql()});
     exec(*lr_.provider, query);
     lr_.provider->refresh();
     emit refresh_sig();
 }
 
+spatial_index_task::spatial_index_task(bark::qt::layer lr) : lr_{std::move(lr)}
+{
+}
+
+void spatial_index_task::run_event()
+{
+    push_output(lr_.uri.toDisplayString(QUrl::DecodeReserved));
+    ::push_output(*this, lr_.name);
+    auto pvd = std::dynamic_pointer_cast<bark::db::sqlite::provider>(
+        lr_.provider);
+    if (!pvd)
+        throw std::runtime_error("not a SQLite layer");
+    pvd->build_spatial_index(lr_.name);
+    emit refresh_sig();
+}
+
 sql_task::sql_task(bark::qt::link lnk, std::string sql)
     : lnk_{std::move(lnk)}, sql_{std::move(sql)}
 {
@@ -80,6 +80,22 @@ private:
     bark::qt::layer lr_;
 };
 
+class spatial_index_task : public task {
+    Q_OBJECT
+
+public:
+    explicit spatial_index_task(bark::qt::layer);
+
+signals:
+    void refresh_sig();
+
+protected:
+    void run_event() override;
+
+private:
+    bark::qt::layer lr_;
+};
+
 class sql_task : public task {
 public:
     sql_task(bark::qt::link, std::string);
@@ -8,11 +8,14 @@
 #include <QDataStream>
 #include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QInputDialog>
 #include <QList>
 #include <QMap>
 #include <QMenu>
 #include <QMessageBox>
+#include <bark/db/gdal/provider.hpp>
+#include <bark/db/sqlite/provider.hpp>
 #include <bark/qt/common_ops.hpp>
 #include <bark/qt/tree_model_impl.hpp>
 
@@ -46,6 +49,9 @@ tree_view::tree_view(QWidget* parent) : QTreeView(parent), model_(nullptr)
     ACTION(attach_uri, QStyle::SP_FileDialogNewFolder, "attach URI");
     ACTION(attributes, "sql", "attributes (limited)");
     ACTION(brush_color, "palette", "filling color");
+    ACTION(build_index,
+           QStyle::SP_FileDialogContentsView,
+           "build spatial index");
     ACTION(copy, "copy", "copy this layer");
     ACTION(copy_checked, "copy", "copy checked layer(s)");
     ACTION(create, QStyle::SP_FileIcon, "new project");
@@ -83,6 +89,11 @@ void tree_view::menu_slot(QPoint point)
             if (clipboard_.size() == 1)
                 acts.append(paste_act_);
             acts.append(metadata_act_);
+            using sqlite_provider = bark::db::sqlite::provider;
+            if (auto pvd =
+                    std::dynamic_pointer_cast<sqlite_provider>(lr->provider);
+                pvd && pvd->spatial_index_advised(lr->name))
+                acts.append(build_index_act_);
         }
         acts.append(attributes_act_);
         acts.append(fit_act_);
@@ -161,8 +172,17 @@ void tree_view::attach_files_slot()
     dlg.setNameFilters(FilterToSchemaMap.keys());
     if (dlg.exec() == QDialog::Accepted) {
         auto schema = FilterToSchemaMap.value(dlg.selectedNameFilter());
-        for (auto& file : dlg.selectedFiles())
+        for (auto& file : dlg.selectedFiles()) {
+            if (schema == "gdal:///" && !QFileInfo::exists(file))
+                try {
+                    bark::db::gdal::create(file.toStdString());
+                }
+                catch (const std::exception& e) {
+                    QMessageBox::critical(this, "create file", e.what());
+                    continue;
+                }
             model_.link_by_uri(schema + file);
+        }
     }
 }
 
@@ -239,6 +259,18 @@ void tree_view::del_slot()
     }
 }
 
+void tree_view::build_index_slot()
+{
+    if (auto lr = model_.get_layer(menu_idx_)) {
+        auto tsk = std::make_shared<spatial_index_task>(*lr);
+        connect(tsk.get(),
+                &spatial_index_task::refresh_sig,
+                this,
+                refreshable(menu_idx_.parent()));
+        emit task_sig(tsk);
+    }
+}
+
 void tree_view::update_slot()
 {
     menu_idx_ = {};
@@ -33,6 +33,7 @@ private slots:
     void attach_uri_slot();
     void attributes_slot();
     void brush_color_slot();
+    void build_index_slot();
     void copy_slot();
     void copy_checked_slot();
     void create_slot();
@@ -60,6 +61,7 @@ private:
     QAction* attach_uri_act_;
     QAction* attributes_act_;
     QAction* brush_color_act_;
+    QAction* build_index_act_;
     QAction* copy_act_;
     QAction* copy_checked_act_;
     QAction* create_act_;
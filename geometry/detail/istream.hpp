@@ -3,11 +3,13 @@
 #ifndef BARK_GEOMETRY_ISTREAM_HPP
 #define BARK_GEOMETRY_ISTREAM_HPP
 
+#include <algorithm>
 #include <bark/detail/wkb.hpp>
 #include <bark/geometry/detail/utility.hpp>
 #include <bark/geometry/geometry.hpp>
 #include <boost/mpl/map.hpp>
 #include <functional>
+#include <vector>
 
 namespace bark::geometry {
 
@@ -85,6 +87,63 @@ public:
     }
 };
 
+/// WKB visitor that flattens vertices to x, y pairs
+class coords_istream {
+    wkb::istream data_;
+    std::vector<double>& dest_;
+
+public:
+    struct none {};
+
+    coords_istream(blob_view data, std::vector<double>& dest)
+        : data_{data}, dest_{dest}
+    {
+    }
+
+    template <class T>
+    void read()
+    {
+        T::accept(data_, *this);
+    }
+
+    none operator()(double x, double y)
+    {
+        dest_.push_back(x);
+        dest_.push_back(y);
+        return {};
+    }
+
+    none operator()(uint32_t count, wkb::path)
+    {
+        auto size = dest_.size() + 2 * size_t(count);
+        if (dest_.capacity() < size)
+            dest_.reserve(std::max(size, 2 * dest_.capacity()));
+        return {};
+    }
+
+    template <class T>
+    none operator()(uint32_t, wkb::chain<T>)
+    {
+        return {};
+    }
+
+    template <class T>
+    void operator()(none, none, T)
+    {
+    }
+
+    template <class T, uint32_t Code>
+    void operator()(wkb::tagged<T, Code>)
+    {
+    }
+
+    template <class T>
+    none operator()(none, T)
+    {
+        return {};
+    }
+};
+
 }  // namespace bark::geometry
 
 #endif  // BARK_GEOMETRY_ISTREAM_HPP
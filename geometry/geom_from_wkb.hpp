@@ -48,6 +48,12 @@ inline auto geom_coll_from_wkb(blob_view v)
     return istream{v}.read<wkb::geometry_collection>();
 }
 
+/// Appends x, y pairs of all vertices
+inline void coords_from_wkb(blob_view v, std::vector<double>& dest)
+{
+    coords_istream{v, dest}.read<wkb::geometry>();
+}
+
 }  // namespace bark::geometry
 
 #endif  // BARK_GEOMETRY_GEOM_FROM_WKB_HPP
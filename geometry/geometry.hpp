@@ -13,6 +13,7 @@
 #include <boost/geometry/multi/geometries/multi_point.hpp>
 #include <boost/geometry/multi/geometries/multi_polygon.hpp>
 #include <boost/variant.hpp>
+#include <utility>
 #include <vector>
 
 namespace bark::geometry {
@@ -43,6 +44,13 @@ using multi_box = std::vector<box>;
 using box_rtree =
     boost::geometry::index::rtree<box, boost::geometry::index::quadratic<16>>;
 
+/// Envelope and number of a feature
+using numbered_box = std::pair<box, size_t>;
+
+using numbered_box_rtree =
+    boost::geometry::index::rtree<numbered_box,
+                                  boost::geometry::index::quadratic<16>>;
+
 }  // namespace bark::geometry
 
 #endif  // BARK_GEOMETRY_GEOMETRY_HPP
@@ -6,6 +6,7 @@
 #include <bark/geometry/geometry.hpp>
 #include <cmath>
 #include <stdexcept>
+#include <type_traits>
 
 namespace bark::geometry {
 
@@ -51,6 +52,30 @@ inline box shift(const box& from, const box& to)
     return {min_corner, max_corner};
 }
 
+bool intersects(const geometry&, const box&);
+
+/// Exact test, unlike the envelopes in R-trees
+inline bool intersects(const geometry_collection& coll, const box& bbox)
+{
+    for (auto& item : coll)
+        if (intersects(item, bbox))
+            return true;
+    return false;
+}
+
+inline bool intersects(const geometry& geom, const box& bbox)
+{
+    return boost::apply_visitor(
+        [&](const auto& item) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(item)>,
+                                         geometry_collection>)
+                return intersects(item, bbox);
+            else
+                return boost::geometry::intersects(item, bbox);
+        },
+        geom);
+}
+
 template <class Point>
 void check(const Point& val)
 {
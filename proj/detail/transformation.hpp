@@ -3,6 +3,7 @@
 #ifndef BARK_PROJ_TRANSFORMATION_HPP
 #define BARK_PROJ_TRANSFORMATION_HPP
 
+#include <bark/detail/trace.hpp>
 #include <bark/proj/detail/utility.hpp>
 #include <stdexcept>
 #include <string>
@@ -27,6 +28,7 @@ public:
 
     void trans_generic(PJ_DIRECTION dir, double* first, double* last) const
     {
+        BARK_TRACE_SCOPE("proj::trans_generic");
         size_t count = (size_t)std::distance(first, last) / 2;
         size_t res = proj_trans_generic(for_gis_.get(),
                                         dir,
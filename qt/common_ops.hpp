@@ -57,6 +57,13 @@ inline auto spatial_objects(const layer& lr,
     return lr.provider->spatial_objects(lr.name, ext, px);
 }
 
+inline auto pick(const layer& lr,
+                 const geometry::box& ext,
+                 const geometry::box& px)
+{
+    return lr.provider->pick(lr.name, ext, px);
+}
+
 inline geometry::box pixel(const georeference& ref)
 {
     auto pos = adapt(ref.center);
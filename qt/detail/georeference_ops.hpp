@@ -90,6 +90,17 @@ inline auto intersect(geometry::box ext)
     };
 }
 
+/// Keeps the scale, but covers the whole extent
+inline auto frame(geometry::box ext)
+{
+    return [ext = std::move(ext)](georeference ref) {
+        auto rect = forward(ref, ext);
+        auto pos = backward(ref, rect.center());
+        auto sz = rect.toAlignedRect().size();
+        return std::move(ref) | set_center(pos) | set_size(sz);
+    };
+}
+
 inline auto fit(geometry::box ext)
 {
     return [ext = std::move(ext)](georeference ref) {
@@ -0,0 +1,80 @@
+// Andrew Naplavkov
+
+#ifndef BARK_QT_IMAGE_CACHE_HPP
+#define BARK_QT_IMAGE_CACHE_HPP
+
+#include <QVector>
+#include <bark/detail/linked_hash_map.hpp>
+#include <bark/detail/lru_cache.hpp>
+#include <bark/qt/detail/geoimage.hpp>
+#include <boost/functional/hash.hpp>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace bark::qt {
+
+/// Thread-safe "Least Recently Used" cache of painted images.
+
+/// Unlike @ref lru_cache, it is bounded by the size of the pixel data, so
+/// large images do not evict the entries of others.
+template <class Key>
+class image_cache {
+public:
+    using scope_type = lru_cache::scope_type;
+    using mapped_type = QVector<geoimage>;
+
+    explicit image_cache(size_t capacity) : capacity_{capacity} {}
+
+    bool contains(scope_type scope, const Key& key)
+    {
+        auto lock = std::lock_guard{guard_};
+        return data_.find({scope, key}) != data_.end();
+    }
+
+    std::optional<mapped_type> find(scope_type scope, const Key& key)
+    {
+        auto lock = std::lock_guard{guard_};
+        auto it = data_.find({scope, key});
+        if (it == data_.end())
+            return std::nullopt;
+        data_.move(it, data_.end());
+        return it->second;
+    }
+
+    void insert(scope_type scope, const Key& key, mapped_type maps)
+    {
+        auto size = bytes(maps);
+        if (size > capacity_)
+            return;
+        auto lock = std::lock_guard{guard_};
+        if (!data_.insert(data_.end(), {{scope, key}, std::move(maps)}).second)
+            return;  // painted concurrently
+        for (size_ += size; size_ > capacity_;) {
+            size_ -= bytes(data_.begin()->second);
+            data_.erase(data_.begin());
+        }
+    }
+
+private:
+    using key_type = std::pair<scope_type, Key>;
+    using container_type =
+        linked_hash_map<key_type, mapped_type, boost::hash<key_type>>;
+
+    const size_t capacity_;
+    std::mutex guard_;
+    container_type data_;
+    size_t size_ = 0;
+
+    static size_t bytes(const mapped_type& maps)
+    {
+        size_t res = 0;
+        for (auto& map : maps)
+            res += size_t(map.img.bytesPerLine()) * map.img.height();
+        return res;
+    }
+};
+
+}  // namespace bark::qt
+
+#endif  // BARK_QT_IMAGE_CACHE_HPP
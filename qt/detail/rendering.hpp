@@ -6,6 +6,7 @@
 #include <QMargins>
 #include <QPainter>
 #include <bark/db/provider.hpp>
+#include <bark/detail/trace.hpp>
 #include <bark/geometry/as_binary.hpp>
 #include <bark/geometry/envelope.hpp>
 #include <bark/geometry/geom_from_wkb.hpp>
@@ -42,9 +43,36 @@ QVector<geoimage> mock_rendering(const layer& lr,
     return {map};
 }
 
-inline QVector<geoimage> geometry_rendering(const layer& lr,
-                                            const geometry::box& tl,
-                                            const georeference& ref)
+/// Loads spatial objects of the tile (I/O-bound part of the rendering)
+inline db::rowset loading(const layer& lr,
+                          const geometry::box& tl,
+                          const georeference& ref)
+{
+    BARK_TRACE_SCOPE("qt::loading");
+    auto tf = proj::transformer{projection(lr), ref.projection};
+    auto px = tf.backward(pixel(ref));
+    return spatial_objects(lr, tl, px);
+}
+
+/// Features of the layer within @p tolerance pixels of the point, mostly
+/// found in the tiles that are cached by the rendering
+inline db::rowset picking(const layer& lr,
+                          const QPointF& pos,
+                          const georeference& ref,
+                          qreal tolerance)
+{
+    BARK_TRACE_SCOPE("qt::picking");
+    auto tf = proj::transformer{projection(lr), ref.projection};
+    auto margin = QPointF{tolerance, tolerance};
+    auto ext = tf.backward(backward(ref, QRectF{pos - margin, pos + margin}));
+    auto px = tf.backward(pixel(ref));
+    return pick(lr, ext, px);
+}
+
+inline QVector<geoimage> geometry_painting(const layer& lr,
+                                           const geometry::box& tl,
+                                           const georeference& ref,
+                                           const db::rowset& objects)
 {
     auto tf = proj::transformer{projection(lr), ref.projection};
     QMargins margin{};
@@ -53,28 +81,25 @@ inline QVector<geoimage> geometry_rendering(const layer& lr,
     if (wnd.size.isEmpty())
         return {};
 
-    auto px = tf.backward(pixel(ref));
-    auto objects = spatial_objects(lr, tl, px);
     auto rows = select(objects);
     if (!tf.is_trivial())
         db::for_each_blob(rows, 0, tf.inplace_forward());
 
+    BARK_TRACE_SCOPE("qt::painter");
     auto map = make<geoimage>(wnd);
     db::for_each_blob(rows, 0, painter{map, lr});
     return {map};
 }
 
-inline QVector<geoimage> raster_rendering(const layer& lr,
-                                          const geometry::box& tl,
-                                          const georeference& ref)
+inline QVector<geoimage> raster_painting(const layer& lr,
+                                         const georeference& ref,
+                                         const db::rowset& objects)
 {
     using namespace geometry;
 
     QVector<geoimage> res;
     auto pj = projection(lr);
     auto tf = proj::transformer{pj, ref.projection};
-    auto px = tf.backward(pixel(ref));
-    auto objects = spatial_objects(lr, tl, px);
     for (auto& row : select(objects)) {
         auto wkb = std::get<blob_view>(row[0]);
         auto bbox = envelope(poly_from_wkb(wkb));
@@ -96,17 +121,22 @@ inline QVector<geoimage> raster_rendering(const layer& lr,
     return res;
 }
 
-inline QVector<geoimage> rendering(const layer& lr,
-                                   const geometry::box& tl,
-                                   const georeference& ref)
+/// Paints loaded spatial objects (CPU-bound part of the rendering).
+
+/// Failures are drawn as a hatched tile.
+inline QVector<geoimage> painting(const layer& lr,
+                                  const geometry::box& tl,
+                                  const georeference& ref,
+                                  const expected<db::rowset>& objects)
 try {
+    BARK_TRACE_SCOPE("qt::painting");
     switch (lr.provider->dir().at(lr.name)) {
         case db::meta::layer_type::Invalid:
             break;
         case db::meta::layer_type::Geometry:
-            return geometry_rendering(lr, tl, ref);
+            return geometry_painting(lr, tl, ref, objects.get());
         case db::meta::layer_type::Raster:
-            return raster_rendering(lr, tl, ref);
+            return raster_painting(lr, ref, objects.get());
     }
     throw std::logic_error("layer type");
 }
@@ -123,6 +153,15 @@ catch (const std::exception& e) {
     return mock_rendering(mock_lr, tl, ref);
 }
 
+inline QVector<geoimage> rendering(const layer& lr,
+                                   const geometry::box& tl,
+                                   const georeference& ref)
+{
+    auto objects =
+        expected<db::rowset>::result_of([&] { return loading(lr, tl, ref); });
+    return painting(lr, tl, ref, objects);
+}
+
 }  // namespace bark::qt
 
 #endif  // BARK_QT_RENDERING_HPP
@@ -5,12 +5,24 @@
 
 #include <QPainter>
 #include <QVector>
+#include <atomic>
+#include <bark/detail/lock_free_stack.hpp>
+#include <bark/detail/lru_cache.hpp>
+#include <bark/detail/trace.hpp>
+#include <bark/qt/detail/image_cache.hpp>
 #include <bark/qt/detail/rendering.hpp>
 #include <bark/qt/detail/start_thread.hpp>
+#include <boost/functional/hash.hpp>
+#include <chrono>
 #include <cmath>
+#include <functional>
 #include <future>
+#include <iostream>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
 
 namespace bark::qt {
 
@@ -21,88 +33,266 @@ inline bool tiny(const geometry::box& tile, const geometry::box& pixel)
            MinTilePixels;
 }
 
+/// Tile painted at the scale and projection of the map
+struct painted_tile {
+    int layer_pos;
+    std::string projection;
+    qreal scale;
+    geometry::box extent;
+
+    friend bool operator==(const painted_tile& lhs, const painted_tile& rhs)
+    {
+        return lhs.tie() == rhs.tie();
+    }
+
+    friend size_t hash_value(const painted_tile& that)
+    {
+        return boost::hash_value(that.tie());
+    }
+
+    auto tie() const
+    {
+        return std::tie(layer_pos,
+                        projection,
+                        scale,
+                        extent.min_corner().x(),
+                        extent.min_corner().y(),
+                        extent.max_corner().x(),
+                        extent.max_corner().y());
+    }
+};
+
+/// Shared by the rendering tasks, the layers are told apart by scopes
+inline image_cache<painted_tile>& painted_tiles()
+{
+    static constexpr size_t Capacity{256 * 1024 * 1024};  ///< bytes
+    static image_cache<painted_tile> res{Capacity};
+    return res;
+}
+
+/// Returns the georeference to paint the whole tile if it is worth caching
+inline std::optional<georeference> tile_frame(const layer& lr,
+                                              const geometry::box& tl,
+                                              const georeference& ref)
+{
+    static constexpr int MaxTilePixels{512 * 512};
+    try {
+        auto tf = proj::transformer{projection(lr), ref.projection};
+        auto res = ref | frame(tf.forward(tl));
+        if (res.size.width() * res.size.height() <= MaxTilePixels)
+            return res;
+    }
+    catch (const std::exception&) {
+    }
+    return std::nullopt;
+}
+
+/// Lock hold times of the rendering task
+struct compositing_stats {
+    size_t tiles = 0;
+    std::chrono::nanoseconds composing{};  ///< the back image is locked
+    std::chrono::nanoseconds publishing{};  ///< the front image is locked
+};
+
 /// Asynchronous painting class. The final image is returned in the destructor.
+
+/// Tiles are loaded and painted by separate executors. Canceled tasks are
+/// dropped from the queues without running.
+/// Painted tiles are pushed to a lock-free stack. A painting thread that
+/// finds the back image free merges all of them, others go on with their
+/// tiles. Snapshots share the front image, so UI does not wait for painters.
 class rendering_task : public std::enable_shared_from_this<rendering_task> {
 public:
-    explicit rendering_task(const georeference& ref) : ref_{ref} {}
+    using callback = std::function<void(const geoimage&)>;
 
-    ~rendering_task() { promise_.set_value({ref_, img_}); }
+    /// @param on_ready is called with the final image, if it is set.
+    explicit rendering_task(const georeference& ref,
+                            rendering_executors execs = default_executors(),
+                            callback on_ready = {})
+        : ref_{ref}, execs_{execs}, on_ready_{std::move(on_ready)}
+    {
+    }
+
+    ~rendering_task()
+    {
+        merge();
+        auto map = geoimage{ref_, back_.isNull() ? make<QImage>(ref_) : back_};
+        if (on_ready_)
+            try {
+                on_ready_(map);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        promise_.set_value(std::move(map));
+    }
 
     std::future<geoimage> get_future() { return promise_.get_future(); }
 
+    /// Returns the recent image without waiting for busy painting threads
     geoimage get_recent()
     {
-        auto lock = std::lock_guard{guard_};
-        return {ref_, img_};
+        if (auto lock = std::unique_lock{back_guard_, std::try_to_lock}) {
+            merge();
+            publish();
+        }
+        auto lock = std::lock_guard{front_guard_};
+        return {ref_, front_};
     }
 
-    void start(QVector<layer> lrs)
+    compositing_stats stats() const
     {
-        static constexpr int PriorityCount{10};
-        for (auto& lr : lrs)
-            start_thread([self = shared_from_this(), lr = std::move(lr)] {
-                self->check();
+        return {tiles_,
+                std::chrono::nanoseconds{composing_},
+                std::chrono::nanoseconds{publishing_}};
+    }
+
+    /// @param scope enables the cache of painted tiles. It must be renewed
+    /// when the layers or their styles change.
+    void start(QVector<layer> lrs,
+               std::optional<lru_cache::scope_type> scope = std::nullopt)
+    {
+        for (int pos = 0; pos < lrs.size(); ++pos) {
+            auto lr_task = [self = shared_from_this(),
+                            lr = std::move(lrs[pos]),
+                            pos,
+                            scope] {
                 auto pj = projection(lr);
                 auto tf = proj::transformer{pj, self->ref_.projection};
                 auto ext = tf.backward(extent(self->ref_));
                 auto px = tf.backward(pixel(self->ref_));
                 auto tls = tile_coverage(lr, ext, px);
-                self->check();
                 if (!tls.empty() && tiny(tls.front(), px)) {
-                    auto mock_lr = lr;
-                    mock_lr.brush.setStyle(Qt::NoBrush);
-                    auto maps = mock_rendering(mock_lr, tls, self->ref_);
-                    self->check();
-                    self->compose(maps);
+                    auto mock_task = [self, lr, tls] {
+                        auto mock_lr = lr;
+                        mock_lr.brush.setStyle(Qt::NoBrush);
+                        self->compose(mock_rendering(mock_lr, tls, self->ref_));
+                    };
+                    start_thread(
+                        self->execs_.painting, mock_task, self->canceled_);
                 }
                 else
-                    for (size_t i = 0; i < tls.size(); ++i) {
-                        auto task = [self, lr, tl = tls[i]] {
-                            self->check();
-                            auto maps = rendering(lr, tl, self->ref_);
-                            self->check();
-                            self->compose(maps);
-                        };
-                        auto priority = PriorityNormal -
-                                        PriorityCount * i / double(tls.size());
-                        start_thread(task, round(priority));
-                    }
-            });
+                    for (auto& tl : tls)  // in order of priority
+                        self->start_tile(lr, pos, scope, tl);
+            };
+            start_thread(execs_.loading, lr_task, canceled_);
+        }
     }
 
-    void cancel()
-    {
-        auto lock = std::lock_guard{guard_};
-        is_canceled_ = true;
-    }
+    void cancel() { *canceled_ = true; }
 
 private:
     const georeference ref_;
+    rendering_executors execs_;
+    const callback on_ready_;
+    const cancel_token canceled_ = make_cancel_token();
     std::promise<geoimage> promise_;
 
-    std::mutex guard_;
-    bool is_canceled_ = false;
-    QImage img_;
+    lock_free_stack<geoimage> painted_;
+    std::mutex back_guard_;
+    QImage back_;
+    std::chrono::steady_clock::time_point published_;
+    std::mutex front_guard_;
+    QImage front_;
+    std::atomic<size_t> tiles_{0};
+    std::atomic<std::chrono::nanoseconds::rep> composing_{0};
+    std::atomic<std::chrono::nanoseconds::rep> publishing_{0};
+
+    void start_tile(const layer& lr,
+                    int pos,
+                    std::optional<lru_cache::scope_type> scope,
+                    const geometry::box& tl)
+    {
+        auto frame = scope ? tile_frame(lr, tl, ref_) : std::nullopt;
+        auto key = painted_tile{pos, ref_.projection, ref_.scale, tl};
+        auto load_task = [self = shared_from_this(),
+                          lr,
+                          tl,
+                          scope,
+                          frame,
+                          key] {
+            auto objects = std::optional<expected<db::rowset>>{};
+            if (!frame || !painted_tiles().contains(*scope, key))
+                objects = self->load(lr, tl);
+            auto paint_task = [self,
+                               lr,
+                               tl,
+                               scope,
+                               frame,
+                               key,
+                               objects = std::move(objects)]() mutable {
+                if (!frame)
+                    return self->compose(
+                        painting(lr, tl, self->ref_, *objects));
+                if (auto maps = painted_tiles().find(*scope, key))
+                    return self->compose(*maps);
+                if (!objects)  // painted tile has been evicted
+                    objects = self->load(lr, tl);
+                auto maps = painting(lr, tl, *frame, *objects);
+                if (!objects->holds_exception<std::exception>())
+                    painted_tiles().insert(*scope, key, maps);  // not errors
+                self->compose(maps);
+            };
+            start_thread(
+                self->execs_.painting, std::move(paint_task), self->canceled_);
+        };
+        start_thread(execs_.loading, std::move(load_task), canceled_);
+    }
 
-    void check()
+    /// Keeps errors to paint them, but gives way to others if busy
+    expected<db::rowset> load(const layer& lr, const geometry::box& tl)
     {
-        auto lock = std::lock_guard{guard_};
-        if (is_canceled_)
-            throw cancel_exception{};
+        auto res = expected<db::rowset>::result_of(
+            [&] { return loading(lr, tl, ref_); });
+        if (res.holds_exception<db::busy_exception>())
+            throw db::busy_exception{};
+        return res;
     }
 
     void compose(const QVector<geoimage>& maps)
     {
-        for (auto& map : maps) {
-            if (map.img.isNull())
-                continue;
-            auto lock = std::lock_guard{guard_};
-            if (img_.isNull())
-                img_ = make<QImage>(ref_);
-            QPainter painter{&img_};
+        static constexpr auto PublishInterval = std::chrono::milliseconds(100);
+        for (auto& map : maps)
+            if (!map.img.isNull())
+                painted_.push(map);
+        // recheck the stack, it could be pushed before the lock was released
+        while (!painted_.empty()) {
+            auto lock = std::unique_lock{back_guard_, std::try_to_lock};
+            if (!lock)
+                return;  // the owner of the lock merges our tiles
+            merge();
+            auto now = std::chrono::steady_clock::now();
+            if (now - published_ >= PublishInterval)
+                publish();
+        }
+    }
+
+    /// Requires back_guard_ or exclusive access
+    void merge()
+    {
+        BARK_TRACE_SCOPE("qt::compose");
+        auto first = std::chrono::steady_clock::now();
+        for (auto maps = painted_.pop_all(); !maps.empty();
+             maps = painted_.pop_all()) {
+            if (back_.isNull())
+                back_ = make<QImage>(ref_);
+            QPainter painter{&back_};
             painter.setCompositionMode(QPainter::CompositionMode_Darken);
-            painter.drawImage(offset(map.ref, ref_), map.img);
+            for (auto& map : maps)
+                painter.drawImage(offset(map.ref, ref_), map.img);
+            tiles_ += maps.size();
         }
+        composing_ += (std::chrono::steady_clock::now() - first).count();
+    }
+
+    /// Requires back_guard_. The next merge detaches the shared image data.
+    void publish()
+    {
+        published_ = std::chrono::steady_clock::now();
+        BARK_TRACE_SCOPE("qt::publish");
+        auto lock = std::lock_guard{front_guard_};
+        front_ = back_;
+        publishing_ += (std::chrono::steady_clock::now() - published_).count();
     }
 };
 
@@ -3,56 +3,54 @@
 #ifndef BARK_QT_START_THREAD_HPP
 #define BARK_QT_START_THREAD_HPP
 
-#include <QRunnable>
-#include <QThreadPool>
 #include <bark/db/provider.hpp>
-#include <functional>
+#include <bark/detail/executor.hpp>
 #include <iostream>
 #include <stdexcept>
 
 namespace bark::qt {
 
-constexpr int PriorityNormal{0};
-
 struct cancel_exception : std::runtime_error {
     cancel_exception() : std::runtime_error{"canceled"} {}
 };
 
-class runnable : public QRunnable {
-public:
-    template <class Functor>
-    runnable(Functor&& f, int priority)
-        : task_{std::forward<Functor>(f)}, priority_{priority}
-    {
-    }
-
-    void run() override;
+/// Separate threads for I/O-bound loading and CPU-bound painting.
 
-private:
-    std::function<void()> task_;
-    const int priority_;
+/// Loading tasks submit painting ones, so painting is stopped last.
+struct rendering_executors {
+    executor& painting;
+    executor& loading;
 };
 
-template <class Functor>
-void start_thread(Functor&& f, int priority = PriorityNormal)
+/// Executors shared by map widgets, see shared_executors::shutdown
+inline rendering_executors default_executors()
 {
-    auto ptr = new runnable(std::forward<Functor>(f), priority);
-    ptr->setAutoDelete(true);
-    QThreadPool::globalInstance()->start(ptr, priority);
+    auto& execs = shared_executors::instance();
+    return {execs.get(shared_executors::pool::Painting),
+            execs.get(shared_executors::pool::Loading)};
 }
 
-inline void runnable::run()
-try {
-    task_();
-}
-catch (const db::busy_exception&) {
-    start_thread(std::move(task_), priority_ - 1);
-}
-catch (const cancel_exception&) {
-    // ignore
-}
-catch (const std::exception& e) {
-    std::cerr << e.what() << std::endl;
+/// Submits the task to the end of the queue. It is resubmitted on
+/// busy_exception to give way to others.
+template <class Functor>
+void start_thread(executor& exec, Functor&& f, cancel_token tok)
+{
+    exec.submit(
+        [&exec, f = std::forward<Functor>(f), tok]() mutable {
+            try {
+                f();
+            }
+            catch (const db::busy_exception&) {
+                start_thread(exec, std::move(f), std::move(tok));
+            }
+            catch (const cancel_exception&) {
+                // ignore
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        },
+        tok);
 }
 
 }  // namespace bark::qt
@@ -3,8 +3,15 @@
 #ifndef BARK_QT_TREE_HPP
 #define BARK_QT_TREE_HPP
 
+#include <QString>
+#include <QUrl>
+#include <bark/detail/executor.hpp>
 #include <bark/qt/common.hpp>
+#include <chrono>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 
 namespace bark::qt {
@@ -15,6 +22,28 @@ struct tree : std::enable_shared_from_this<tree> {
     tree* parent = nullptr;
     std::vector<std::shared_ptr<tree>> children;
     node data;
+    QString key;  ///< display string of data, children are sorted by it
+};
+
+/// Data source that is being linked in the background.
+
+/// The I/O thread publishes the start time, the branch as soon as it
+/// connects and then the sorted leaves. The rest is accessed by the model
+/// thread only.
+struct branch_loading {
+    QUrl uri;
+    cancel_token tok = make_cancel_token();
+
+    std::mutex guard;
+    std::optional<std::chrono::steady_clock::time_point> started;
+    std::shared_ptr<tree> branch;  ///< without children
+    std::vector<std::shared_ptr<tree>> leaves;  ///< immutable when done
+    std::exception_ptr error;
+    bool done = false;
+
+    bool inserted = false;
+    size_t next_leaf = 0;
+    std::shared_ptr<tree> previous;  ///< replaced branch with old settings
 };
 
 }  // namespace bark::qt
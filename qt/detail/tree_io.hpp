@@ -67,7 +67,7 @@ template <>
 inline std::shared_ptr<tree> read<std::shared_ptr<tree>>(QDataStream& is)
 {
     auto res = std::make_shared<tree>();
-    res->data = read<node>(is);
+    set_data(res.get(), read<node>(is));
     res->children.resize(read<quint32>(is));
     for (auto& child : res->children) {
         child = read<std::shared_ptr<tree>>(is);
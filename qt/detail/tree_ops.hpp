@@ -11,9 +11,11 @@
 #include <bark/db/postgres/provider.hpp>
 #include <bark/db/slippy/provider.hpp>
 #include <bark/db/sqlite/provider.hpp>
+#include <bark/detail/executor.hpp>
 #include <bark/qt/detail/adapt.hpp>
 #include <bark/qt/detail/tree.hpp>
 #include <boost/lexical_cast.hpp>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 
@@ -100,39 +102,74 @@ inline QString to_string(tree* ptr)
         ptr->data);
 }
 
+/// Sets the node data and its sort key
+inline void set_data(tree* ptr, node data)
+{
+    ptr->data = std::move(data);
+    ptr->key = to_string(ptr);
+}
+
 inline auto binary_search(tree* parent, tree* child)
 {
-    return std::equal_range(parent->children.begin(),
-                            parent->children.end(),
-                            child->shared_from_this(),
-                            [](const auto& lhs, const auto& rhs) {
-                                return to_string(lhs.get()) <
-                                       to_string(rhs.get());
-                            });
-}
-
-inline std::shared_ptr<tree> dir(const QUrl& uri)
-{
-    auto res = std::make_shared<tree>();
-    auto lnk = make_link(uri);
-    res->data = lnk;
-    for (const auto& pair : lnk.provider->dir()) {
-        layer_settings lr;
-        lr.name = pair.first;
-        auto child = std::make_shared<tree>();
-        child->parent = res.get();
-        child->data = lr;
-        res->children.push_back(child);
+    return std::equal_range(
+        parent->children.begin(),
+        parent->children.end(),
+        child->shared_from_this(),
+        [](const auto& lhs, const auto& rhs) { return lhs->key < rhs->key; });
+}
+
+/// Dedicated I/O threads, so unreachable servers do not delay rendering.
+
+/// A timed out @ref load is canceled only before it starts. A running one
+/// keeps its thread until the driver gives up, so four unreachable servers
+/// delay the next links.
+inline executor& linking_executor()
+{
+    return shared_executors::instance().get(shared_executors::pool::Linking);
+}
+
+/// Connects to the data source and lists its layers
+inline void load(branch_loading& ldg)
+{
+    {
+        auto lock = std::lock_guard{ldg.guard};
+        ldg.started = std::chrono::steady_clock::now();
+    }
+    try {
+        auto branch = std::make_shared<tree>();
+        set_data(branch.get(), make_link(ldg.uri));
+        {
+            auto lock = std::lock_guard{ldg.guard};
+            ldg.branch = branch;
+        }
+        std::vector<std::shared_ptr<tree>> leaves;
+        for (const auto& pair : std::get<link>(branch->data).provider->dir()) {
+            layer_settings lr;
+            lr.name = pair.first;
+            auto leaf = std::make_shared<tree>();
+            leaf->parent = branch.get();
+            set_data(leaf.get(), std::move(lr));
+            leaves.push_back(std::move(leaf));
+        }
+        std::sort(leaves.begin(), leaves.end(), [](auto& lhs, auto& rhs) {
+            return lhs->key < rhs->key;
+        });
+        auto lock = std::lock_guard{ldg.guard};
+        ldg.leaves = std::move(leaves);
+        ldg.done = true;
+    }
+    catch (...) {
+        auto lock = std::lock_guard{ldg.guard};
+        ldg.error = std::current_exception();
+        ldg.done = true;
     }
-    return res;
 }
 
-inline void copy_children_data(tree* from, tree* to)
+/// Keeps the settings of the same layer from the old branch
+inline void copy_data(tree* from, tree* to)
 {
-    for (auto& child : to->children)
-        if (auto rng = binary_search(from, child.get());
-            rng.first != rng.second)
-            child->data = (*rng.first)->data;
+    if (auto rng = binary_search(from, to); rng.first != rng.second)
+        to->data = (*rng.first)->data;
 }
 
 inline bool is_link(tree* ptr)
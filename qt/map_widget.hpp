@@ -11,6 +11,8 @@
 #include <QTimerEvent>
 #include <QVector>
 #include <QWidget>
+#include <bark/db/rowset.hpp>
+#include <bark/detail/lru_cache.hpp>
 #include <bark/qt/common.hpp>
 #include <bark/qt/detail/geoimage.hpp>
 #include <future>
@@ -40,6 +42,9 @@ public:
     /// Changes projection and scale to avoid distortion
     void undistort(layer);
 
+    /// Returns features under the cursor for every shown layer
+    QVector<db::rowset> pick(QPoint pos, qreal tolerance = 2) const;
+
 protected:
     /// Called when the map starts to draw
     virtual void active_event() {}
@@ -72,6 +77,7 @@ private:
     geoimage map_;
     std::future<geoimage> future_map_;
     QVector<layer> layers_;
+    lru_cache::scope_type painted_tiles_;
     std::weak_ptr<rendering_task> render_;
     QPointF press_center_;
     QPoint press_pos_;
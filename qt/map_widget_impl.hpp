@@ -18,6 +18,7 @@ inline map_widget::map_widget(QWidget* parent)
     : QWidget(parent)
     , ref_{make_globe_mercator(size())}
     , map_{make<geoimage>(ref_)}
+    , painted_tiles_{lru_cache::new_scope()}
 {
     setMouseTracking(true);
 }
@@ -53,7 +54,7 @@ inline void map_widget::start_rendering()
     auto render = std::make_shared<rendering_task>(ref_);
     future_map_ = render->get_future();
     render_ = render;
-    render->start(layers_);
+    render->start(layers_, painted_tiles_);
     timer_.start(duration_cast<milliseconds>(UiTimeout).count(), this);
     active_event();
 }
@@ -75,6 +76,7 @@ inline void map_widget::fit(layer lr)
 inline void map_widget::show(QVector<layer> lrs)
 {
     layers_ = std::move(lrs);
+    painted_tiles_ = lru_cache::new_scope();
     start_rendering();
 }
 
@@ -84,6 +86,19 @@ inline void map_widget::undistort(layer lr)
         [ref = ref_, lr = std::move(lr)] { return ref | qt::undistort(lr); });
 }
 
+inline QVector<db::rowset> map_widget::pick(QPoint pos, qreal tolerance) const
+{
+    QVector<db::rowset> res;
+    for (auto& lr : layers_)
+        try {
+            res.push_back(picking(lr, pos, ref_, tolerance));
+        }
+        catch (const std::exception&) {
+            res.push_back({});
+        }
+    return res;
+}
+
 inline QPointF map_widget::lon_lat(QMouseEvent* event) const
 try {
     proj::transformer tf(ref_.projection, proj::epsg().find_proj(4326));
@@ -0,0 +1,107 @@
+// Andrew Naplavkov
+
+#ifndef BARK_QT_RENDERER_HPP
+#define BARK_QT_RENDERER_HPP
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QVector>
+#include <algorithm>
+#include <bark/blob.hpp>
+#include <bark/db/slippy/detail/layer.hpp>
+#include <bark/qt/detail/georeference_ops.hpp>
+#include <bark/qt/detail/rendering_task.hpp>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace bark::qt {
+
+/// Draws data sets off-screen, without widgets and the event loop.
+
+/// Requests are served concurrently by own threads, so a server or batch job
+/// does not compete with the global thread pool of the application.
+class renderer {
+public:
+    using callback = rendering_task::callback;
+
+    /// @param threads is the number of painting threads.
+    explicit renderer(
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency()))
+        : painting_{threads}, loading_{2 * threads}
+    {
+    }
+
+    /// Unfinished requests are completed with the images painted so far
+    ~renderer() = default;
+
+    renderer(const renderer&) = delete;
+    renderer& operator=(const renderer&) = delete;
+
+    /// Draws data sets within the georeference
+    std::future<geoimage> render(const georeference& ref, QVector<layer> lrs)
+    {
+        return start(ref, std::move(lrs), {});
+    }
+
+    /// Calls back in a painting thread when the image is ready
+    void render(const georeference& ref, QVector<layer> lrs, callback f)
+    {
+        start(ref, std::move(lrs), std::move(f));
+    }
+
+private:
+    executor painting_;
+    executor loading_;  ///< submits painting, so it is destroyed first
+
+    std::future<geoimage> start(const georeference& ref,
+                                QVector<layer> lrs,
+                                callback f)
+    {
+        auto task = std::make_shared<rendering_task>(
+            ref, rendering_executors{painting_, loading_}, std::move(f));
+        auto res = task->get_future();
+        task->start(std::move(lrs));
+        return res;
+    }
+};
+
+/// Returns pixels in RGBA order, row by row, without padding
+inline blob rgba(const QImage& img)
+{
+    auto tmp = img.convertToFormat(QImage::Format_RGBA8888);
+    auto row_size = size_t(tmp.width()) * 4;
+    blob res(row_size * tmp.height());
+    for (int row = 0; row < tmp.height(); ++row)
+        std::copy_n(reinterpret_cast<const std::byte*>(tmp.constScanLine(row)),
+                    row_size,
+                    res.data() + row * row_size);
+    return res;
+}
+
+/// Encodes the image in PNG format
+inline blob png(const QImage& img)
+{
+    QByteArray bytes;
+    QBuffer buf{&bytes};
+    buf.open(QIODevice::WriteOnly);
+    if (!img.save(&buf, "PNG"))
+        throw std::runtime_error("save image error");
+    auto first = reinterpret_cast<const std::byte*>(bytes.constData());
+    return {first, first + bytes.size()};
+}
+
+/// Returns the georeference of the slippy map tile (for the tile seeding)
+inline georeference make_georeference(const db::slippy::tile& tl)
+{
+    auto tf = db::slippy::tile_to_layer_transformer();
+    return georeference{} | set_size(QSize{db::slippy::Pixels,
+                                           db::slippy::Pixels}) |
+           set_projection(db::slippy::projection()) |
+           fit(tf.forward(db::slippy::extent(tl)));
+}
+
+}  // namespace bark::qt
+
+#endif  // BARK_QT_RENDERER_HPP
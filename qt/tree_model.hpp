@@ -6,8 +6,6 @@
 #include <QAbstractItemModel>
 #include <QBasicTimer>
 #include <QDataStream>
-#include <QFuture>
-#include <QList>
 #include <QModelIndex>
 #include <QTimerEvent>
 #include <QUrl>
@@ -15,13 +13,26 @@
 #include <QVector>
 #include <bark/qt/common.hpp>
 #include <bark/qt/detail/tree.hpp>
+#include <chrono>
+#include <memory>
 #include <optional>
+#include <vector>
 
 namespace bark::qt {
 
-/// A hierarchical collection of data sets
+/// A hierarchical collection of data sets.
+
+/// Data sources are linked on dedicated I/O threads. A source appears as
+/// soon as it connects, then its layers are inserted in batches.
 class tree_model : public QAbstractItemModel {
 public:
+    /// Time to connect and list the layers, the source is removed after it.
+    /// A blocked driver call still holds its I/O thread until it returns.
+    static constexpr std::chrono::seconds LinkTimeout{10};
+
+    /// Layers inserted at once, so the view stays responsive
+    static constexpr size_t BatchSize = 1000;
+
     explicit tree_model(QObject* parent);
 
     /// Adds new data source
@@ -71,10 +82,16 @@ protected:
 
 private:
     std::shared_ptr<tree> root_;
-    QList<QFuture<std::shared_ptr<tree>>> future_branches_;
+    std::vector<std::shared_ptr<branch_loading>> loadings_;
     QBasicTimer timer_;
 
     tree* to_ptr(const QModelIndex&) const;
+
+    /// @return true if the loading is over
+    bool poll(branch_loading&);
+
+    /// Removes the branch of a failed loading, restores the replaced one
+    void discard(branch_loading&);
 };
 
 }  // namespace bark::qt
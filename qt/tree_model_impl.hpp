@@ -4,12 +4,12 @@
 #ifndef BARK_QT_TREE_MODEL_IMPL_HPP
 #define BARK_QT_TREE_MODEL_IMPL_HPP
 
-#include <QtConcurrent/QtConcurrentRun>
 #include <bark/detail/utility.hpp>
 #include <bark/qt/detail/tree_io.hpp>
 #include <bark/qt/detail/tree_ops.hpp>
 #include <bark/qt/tree_model.hpp>
 #include <exception>
+#include <iostream>
 
 namespace bark::qt {
 
@@ -30,13 +30,17 @@ inline tree* tree_model::to_ptr(const QModelIndex& idx) const
 
 inline void tree_model::link_by_uri(QUrl uri)
 {
-    future_branches_.push_back(
-        QtConcurrent::run([uri = std::move(uri)] { return dir(uri); }));
+    auto ldg = std::make_shared<branch_loading>();
+    ldg->uri = std::move(uri);
+    linking_executor().submit([ldg] { load(*ldg); }, ldg->tok);
+    loadings_.push_back(std::move(ldg));
 }
 
 inline void tree_model::reset()
 {
-    future_branches_.clear();
+    for (auto& ldg : loadings_)
+        *ldg->tok = true;
+    loadings_.clear();
     if (!root_->children.empty())
         removeRows(0, (int)root_->children.size());
 }
@@ -46,30 +50,95 @@ inline void tree_model::timerEvent(QTimerEvent* event)
     if (event->timerId() != timer_.timerId())
         return QAbstractItemModel::timerEvent(event);
 
-    for (auto it = future_branches_.begin(); it != future_branches_.end();) {
-        if (it->resultCount() && it->isResultReadyAt(0)) {
-            try {
-                auto branch = it->resultAt(0);
-                auto rng = binary_search(root_.get(), branch.get());
-                auto row = rng.first - root_->children.begin();
-                if (rng.first != rng.second) {
-                    copy_children_data(rng.first->get(), branch.get());
-                    removeRows(row, rng.second - rng.first);
-                }
-
-                beginInsertRows({}, row, row);
-                branch->parent = root_.get();
-                root_->children.insert(root_->children.begin() + row, branch);
-                endInsertRows();
-            }
-            catch (const std::exception& e) {
-                std::cerr << e.what() << std::endl;
-            }
-            it = future_branches_.erase(it);
-        }
+    for (auto it = loadings_.begin(); it != loadings_.end();)
+        if (poll(**it))
+            it = loadings_.erase(it);
         else
             ++it;
+}
+
+inline bool tree_model::poll(branch_loading& ldg)
+{
+    auto lock = std::unique_lock{ldg.guard};
+    auto branch = ldg.branch;
+    auto error = ldg.error;
+    auto done = ldg.done;
+    auto started = ldg.started;
+    lock.unlock();
+
+    try {
+        if (error)
+            std::rethrow_exception(error);
+        // the clock starts in the I/O thread, not while queued behind others
+        if (!done && started &&
+            std::chrono::steady_clock::now() - *started > LinkTimeout) {
+            *ldg.tok = true;
+            throw std::runtime_error("timeout: " + adapt(ldg.uri.toString()));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        discard(ldg);
+        return true;
     }
+    if (!branch)
+        return false;
+
+    if (!ldg.inserted) {
+        auto rng = binary_search(root_.get(), branch.get());
+        auto row = rng.first - root_->children.begin();
+        if (rng.first != rng.second) {
+            ldg.previous = *rng.first;
+            removeRows(row, rng.second - rng.first);
+        }
+        beginInsertRows({}, row, row);
+        branch->parent = root_.get();
+        root_->children.insert(root_->children.begin() + row, branch);
+        endInsertRows();
+        ldg.inserted = true;
+    }
+    if (!done)
+        return false;
+
+    // the branch may have been removed or replaced meanwhile
+    auto rng = binary_search(root_.get(), branch.get());
+    auto it = std::find(rng.first, rng.second, branch);
+    if (it == rng.second)
+        return true;
+    auto first = ldg.next_leaf;
+    auto last = std::min(ldg.leaves.size(), first + BatchSize);
+    if (first < last) {
+        if (ldg.previous)
+            for (auto i = first; i < last; ++i)
+                copy_data(ldg.previous.get(), ldg.leaves[i].get());
+        auto parent =
+            createIndex(int(it - root_->children.begin()), 0, branch.get());
+        beginInsertRows(parent, (int)first, int(last - 1));
+        branch->children.insert(branch->children.end(),
+                                ldg.leaves.begin() + first,
+                                ldg.leaves.begin() + last);
+        endInsertRows();
+        ldg.next_leaf = last;
+    }
+    return last == ldg.leaves.size();
+}
+
+inline void tree_model::discard(branch_loading& ldg)
+{
+    if (!ldg.inserted)
+        return;
+    // the branch may have been removed or replaced meanwhile
+    auto rng = binary_search(root_.get(), ldg.branch.get());
+    auto it = std::find(rng.first, rng.second, ldg.branch);
+    if (it == rng.second)
+        return;
+    auto row = int(it - root_->children.begin());
+    removeRows(row, 1);
+    if (!ldg.previous)
+        return;
+    beginInsertRows({}, row, row);
+    root_->children.insert(root_->children.begin() + row, ldg.previous);
+    endInsertRows();
 }
 
 inline std::optional<link> tree_model::get_link(const QModelIndex& idx) const
@@ -173,7 +242,9 @@ inline QDataStream& operator<<(QDataStream& os, const tree_model& that)
 
 inline QDataStream& operator>>(QDataStream& is, tree_model& that)
 {
-    that.future_branches_.clear();
+    for (auto& ldg : that.loadings_)
+        *ldg->tok = true;
+    that.loadings_.clear();
     auto root = read<std::shared_ptr<tree>>(is);
     that.removeRows(0, (int)that.root_->children.size());
     that.beginInsertRows({}, 0, (int)root->children.size());
@@ -0,0 +1,571 @@
+// Andrew Naplavkov
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bark/db/copier.hpp>
+#include <bark/db/gdal/provider.hpp>
+#include <bark/db/postgres/provider.hpp>
+#include <bark/db/slippy/detail/layer.hpp>
+#include <bark/db/slippy/detail/tile.hpp>
+#include <bark/db/slippy/mvt.hpp>
+#include <bark/db/sqlite/provider.hpp>
+#include <bark/db/wkb_decoder.hpp>
+#include <bark/detail/lru_cache.hpp>
+#include <bark/geometry/as_binary.hpp>
+#include <bark/geometry/as_text.hpp>
+#include <bark/geometry/geom_from_text.hpp>
+#include <bark/geometry/geom_from_wkb.hpp>
+#include <bark/proj/epsg.hpp>
+#include <bark/proj/transformer.hpp>
+#include <bark/qt/renderer.hpp>
+#include <bark/test/synthetic.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+/// Micro and macro benchmarks on local data.
+
+/// Run from the test directory: make -f makefile.ubuntu bench
+/// Results are written to bench.json for comparison with tools/compare.py
+/// from the Google Benchmark distribution.
+
+namespace {
+
+using namespace bark;
+
+struct sample {
+    db::provider_ptr pvd;
+    db::qualified_name layer;
+    db::rowset objects;  ///< geometry column first
+    std::vector<blob> wkbs;
+    std::vector<std::string> wkts;
+};
+
+const sample& vector_sample()
+{
+    static const auto res = [] {
+        sample res;
+        res.pvd = std::make_shared<db::gdal::provider>("./data/mexico.sqlite");
+        for (auto& [nm, type] : res.pvd->dir())
+            if (type == db::meta::layer_type::Geometry) {
+                res.layer = nm;
+                break;
+            }
+        auto ext = res.pvd->extent(res.layer);
+        auto px = geometry::box{ext.min_corner(), ext.min_corner()};
+        res.objects = res.pvd->spatial_objects(res.layer, ext, px);
+        for (auto& row : db::select(res.objects)) {
+            auto wkb = std::get<blob_view>(row[0]);
+            res.wkbs.emplace_back(wkb.begin(), wkb.end());
+            res.wkts.push_back(
+                geometry::as_text(geometry::geom_from_wkb(wkb)));
+        }
+        return res;
+    }();
+    return res;
+}
+
+void wkb_parse(benchmark::State& state)
+{
+    auto& smp = vector_sample();
+    for (auto _ : state)
+        for (auto& wkb : smp.wkbs)
+            benchmark::DoNotOptimize(geometry::geom_from_wkb(wkb));
+    state.SetItemsProcessed(state.iterations() * smp.wkbs.size());
+}
+BENCHMARK(wkb_parse);
+
+void wkb_write(benchmark::State& state)
+{
+    auto& smp = vector_sample();
+    std::vector<geometry::geometry> geoms;
+    for (auto& wkb : smp.wkbs)
+        geoms.push_back(geometry::geom_from_wkb(wkb));
+    for (auto _ : state)
+        for (auto& geom : geoms)
+            benchmark::DoNotOptimize(geometry::as_binary(geom));
+    state.SetItemsProcessed(state.iterations() * geoms.size());
+}
+BENCHMARK(wkb_write);
+
+void wkt_parse(benchmark::State& state)
+{
+    auto& smp = vector_sample();
+    for (auto _ : state)
+        for (auto& wkt : smp.wkts)
+            benchmark::DoNotOptimize(geometry::geom_from_text(wkt));
+    state.SetItemsProcessed(state.iterations() * smp.wkts.size());
+}
+BENCHMARK(wkt_parse);
+
+void rowset_select(benchmark::State& state)
+{
+    auto& smp = vector_sample();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(db::select(smp.objects));
+    state.SetBytesProcessed(state.iterations() * smp.objects.data.size());
+}
+BENCHMARK(rowset_select);
+
+void sql_building(benchmark::State& state)
+{
+    auto& smp = vector_sample();
+    auto wkb = geometry::as_binary(smp.pvd->extent(smp.layer));
+    for (auto _ : state) {
+        db::sql_builder bld{[](auto id) { return concat('"', id, '"'); },
+                            [](auto) { return "?"; }};
+        bld << "SELECT ";
+        for (auto& col : smp.objects.columns)
+            bld << db::id(col) << ", ";
+        bld << "1 FROM " << qualifier(smp.layer) << " WHERE MbrIntersects("
+            << db::id(smp.layer.back()) << ", " << db::param{blob_view{wkb}}
+            << ") AND id > " << db::param{42} << " LIMIT " << 100;
+        benchmark::DoNotOptimize(bld.sql());
+    }
+}
+BENCHMARK(sql_building);
+
+proj::transformer wgs84_to_mercator()
+{
+    return {proj::epsg().find_proj(4326), proj::epsg().find_proj(3857)};
+}
+
+void transform_box(benchmark::State& state)
+{
+    auto tf = wgs84_to_mercator();
+    auto ext = geometry::box{{-118, 14}, {-86, 33}};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(tf.forward(ext));
+}
+BENCHMARK(transform_box);
+
+void transform_wkb(benchmark::State& state)
+{
+    auto& smp = vector_sample();
+    auto tf = proj::transformer{smp.pvd->projection(smp.layer),
+                                proj::epsg().find_proj(3857)};
+    auto wkbs = smp.wkbs;
+    size_t bytes = 0;
+    for (auto& wkb : wkbs)
+        bytes += wkb.size();
+    for (auto _ : state) {
+        for (auto& wkb : wkbs) {
+            tf.inplace_forward(wkb);
+            tf.inplace_backward(wkb);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(transform_wkb);
+
+void make_tiles(benchmark::State& state)
+{
+    auto ext = geometry::box{{-118, 14}, {-86, 33}};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(db::make_tiles(state.range(0), ext));
+}
+BENCHMARK(make_tiles)->Range(1 << 12, 1 << 24);
+
+void slippy_tile_coverage(benchmark::State& state)
+{
+    auto ext = geometry::box{{-118, 14}, {-86, 33}};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            db::slippy::tile_coverage(ext, (int)state.range(0)));
+}
+BENCHMARK(slippy_tile_coverage)->DenseRange(4, 12, 4);
+
+void lru_cache_contention(benchmark::State& state)
+{
+    static const auto Scope = lru_cache::new_scope();
+    static constexpr int Keys = 64;
+    int key = state.thread_index();
+    size_t busy = 0;
+    for (auto _ : state) {
+        try {
+            benchmark::DoNotOptimize(lru_cache::get_or_invoke(
+                Scope, key, [](int k) { return k; }, key));
+        }
+        catch (const lru_cache::busy_exception&) {
+            ++busy;
+        }
+        key = (key + 1) % Keys;
+    }
+    state.counters["busy"] = double(busy);
+}
+BENCHMARK(lru_cache_contention)->ThreadRange(1, 8)->UseRealTime();
+
+void mvt_encoding(benchmark::State& state)
+{
+    auto& smp = vector_sample();
+    auto tf = db::slippy::tile_to_layer_transformer();
+    auto ext = proj::transformer{smp.pvd->projection(smp.layer),
+                                 db::slippy::projection()}
+                   .forward(smp.pvd->extent(smp.layer));
+    auto tls = db::slippy::tile_coverage(tf.backward(ext), (int)state.range(0));
+    size_t bytes = 0;
+    for (auto _ : state)
+        for (auto& tl : tls)
+            bytes += db::slippy::make_mvt(*smp.pvd, {smp.layer}, tl).size();
+    state.SetItemsProcessed(state.iterations() * tls.size());
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(mvt_encoding)->DenseRange(4, 8, 2)->Unit(benchmark::kMillisecond);
+
+qt::layer make_layer(db::provider_ptr pvd, db::qualified_name name)
+{
+    auto res = qt::layer{};
+    res.provider = std::move(pvd);
+    res.name = std::move(name);
+    res.pen = QPen{Qt::darkBlue};
+    res.brush = QBrush{Qt::cyan};
+    return res;
+}
+
+void render(benchmark::State& state, const qt::layer& lr)
+{
+    static qt::renderer rnd;
+    auto ref = qt::georeference{} | qt::set_size(QSize{1024, 1024}) |
+               qt::set_projection(qt::projection(lr)) |
+               qt::fit(qt::extent(lr));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(rnd.render(ref, {lr}).get());
+}
+
+void rendering(benchmark::State& state, const char* file)
+{
+    auto pvd = std::make_shared<db::gdal::provider>(file);
+    auto name = pvd->dir().begin()->first;
+    render(state, make_layer(pvd, name));
+}
+BENCHMARK_CAPTURE(rendering, vector, "./data/mexico.sqlite")
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(rendering, raster, "./data/albers27.tif")
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Generated once, reused by the next runs
+bool generated(const std::string& file, std::function<void(std::string)> f)
+{
+    if (std::ifstream{file}.good())
+        return false;
+    // the extension is kept, drivers are chosen by it
+    auto dot = file.rfind('.');
+    auto tmp = file.substr(0, dot) + ".tmp" + file.substr(dot);
+    std::remove(tmp.c_str());
+    f(tmp);
+    if (std::rename(tmp.c_str(), file.c_str()))
+        throw std::runtime_error("rename " + tmp);
+    return true;
+}
+
+/// Spatialite or GeoPackage layer of polygons clustered around hot spots
+qt::layer synthetic_layer(size_t features, bool gpkg = false)
+{
+    auto file = concat("./synthetic_", features, gpkg ? ".gpkg" : ".sqlite");
+    generated(file, [&](std::string tmp) {
+        auto opts = synthetic::options{};
+        opts.features = features;
+        opts.type = synthetic::shape::Polygon;
+        opts.skew = .5;
+        opts.feature_size = 1. / std::sqrt(features);
+        if (gpkg)
+            synthetic::make_gpkg(tmp, "synthetic", opts);
+        else {
+            auto pvd = db::sqlite::provider{tmp};
+            synthetic::make_layer(pvd, "synthetic", opts);
+        }
+    });
+    auto pvd = db::provider_ptr{};
+    if (gpkg)
+        pvd = std::make_shared<db::gdal::provider>(file);
+    else
+        pvd = std::make_shared<db::sqlite::provider>(file);
+    auto name = pvd->dir().begin()->first;
+    return make_layer(pvd, name);
+}
+
+void synthetic_tile_coverage(benchmark::State& state)
+{
+    auto lr = synthetic_layer(state.range(0));
+    auto ext = qt::extent(lr);
+    for (auto _ : state) {
+        state.PauseTiming();
+        lr.provider->refresh();
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(qt::tile_coverage(lr, ext, ext));
+    }
+}
+BENCHMARK(synthetic_tile_coverage)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+/// Windows of 1% of the extent at reproducible locations
+void synthetic_spatial_objects(benchmark::State& state, bool gpkg)
+{
+    auto lr = synthetic_layer(state.range(0), gpkg);
+    auto ext = qt::extent(lr);
+    auto width = ext.max_corner().x() - ext.min_corner().x();
+    auto height = ext.max_corner().y() - ext.min_corner().y();
+    auto gen = synthetic::generator{synthetic::options{}};
+    size_t rows = 0;
+    for (auto _ : state) {
+        auto x = ext.min_corner().x() + gen.canonical() * width * .9;
+        auto y = ext.min_corner().y() + gen.canonical() * height * .9;
+        auto wnd = geometry::box{{x, y}, {x + width / 10, y + height / 10}};
+        auto px = geometry::box{{x, y}, {x + width / 1e4, y + height / 1e4}};
+        auto objects = qt::spatial_objects(lr, wnd, px);
+        rows += db::select(objects).size();
+    }
+    state.SetItemsProcessed(rows);
+}
+BENCHMARK_CAPTURE(synthetic_spatial_objects, spatialite, false)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(synthetic_spatial_objects, gpkg, true)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+void synthetic_rendering(benchmark::State& state)
+{
+    render(state, synthetic_layer(state.range(0)));
+}
+BENCHMARK(synthetic_rendering)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void synthetic_raster_rendering(benchmark::State& state)
+{
+    auto side = int(state.range(0));
+    auto file = concat("./synthetic_", side, ".tif");
+    generated(file, [&](std::string tmp) {
+        synthetic::make_geotiff(tmp, side, side);
+    });
+    auto pvd = std::make_shared<db::gdal::provider>(file);
+    auto name = pvd->dir().begin()->first;
+    render(state, make_layer(pvd, name));
+}
+BENCHMARK(synthetic_raster_rendering)
+    ->RangeMultiplier(4)
+    ->Range(1024, 16384)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Export to a new GeoPackage via OGR API
+void synthetic_gpkg_export(benchmark::State& state)
+{
+    auto opts = synthetic::options{};
+    opts.features = state.range(0);
+    opts.type = synthetic::shape::Polygon;
+    auto file = std::string{"./synthetic_export.gpkg"};
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::remove(file.c_str());
+        state.ResumeTiming();
+        db::gdal::create(file);
+        auto pvd = db::gdal::provider{file};
+        synthetic::make_layer(pvd, "synthetic", opts);
+    }
+    std::remove(file.c_str());
+    state.SetItemsProcessed(state.iterations() * opts.features);
+}
+BENCHMARK(synthetic_gpkg_export)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 1'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+/// Copy of a synthetic table to a new Spatialite file by parallel readers
+void synthetic_copy(benchmark::State& state)
+{
+    auto from = synthetic_layer(state.range(0));
+    auto tbl = from.provider->table(qualifier(from.name));
+    auto cols = db::names(tbl.columns);
+    auto file = std::string{"./synthetic_copy.sqlite"};
+    auto opts = db::copying_options{};
+    opts.readers = unsigned(state.range(1));
+    db::copying_stats stats;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::remove(file.c_str());
+        auto to = db::sqlite::provider{file};
+        auto [tbl_nm, ddl] = to.ddl(tbl);
+        db::exec(to, ddl);
+        to.refresh();
+        state.ResumeTiming();
+        stats = db::copy_table(
+            *from.provider, tbl.name, cols, to, tbl_nm, cols, opts);
+    }
+    std::remove(file.c_str());
+    state.SetItemsProcessed(state.iterations() * stats.rows);
+    state.counters["reading_rows_per_sec"] =
+        stats.rows_per_second(stats.reading);
+    state.counters["transforming_rows_per_sec"] =
+        stats.rows_per_second(stats.transforming);
+    state.counters["writing_rows_per_sec"] =
+        stats.rows_per_second(stats.writing);
+}
+BENCHMARK(synthetic_copy)
+    ->ArgsProduct({{100'000, 1'000'000}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Load into an empty table, the spatial index is maintained row by row or
+/// created after the load
+void bulk_load(benchmark::State& state, db::provider& to)
+{
+    auto from = synthetic_layer(state.range(0));
+    auto tbl = from.provider->table(qualifier(from.name));
+    auto cols = db::names(tbl.columns);
+    auto opts = db::copying_options{};
+    opts.rebuild_indexes = bool(state.range(1));
+    db::copying_stats stats;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto [tbl_nm, ddl] = to.ddl(tbl);
+        db::exec(to, ddl);
+        to.refresh();
+        state.ResumeTiming();
+        stats = db::copy_table(
+            *from.provider, tbl.name, cols, to, tbl_nm, cols, opts);
+        state.PauseTiming();
+        db::exec(to, db::drop_sql(to, tbl_nm));
+        to.refresh();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * stats.rows);
+    state.counters["writing_sec"] = stats.writing.count();
+    state.counters["indexing_sec"] = stats.indexing.count();
+}
+
+void synthetic_bulk_load(benchmark::State& state)
+{
+    auto file = std::string{"./synthetic_bulk_load.sqlite"};
+    std::remove(file.c_str());
+    {
+        auto to = db::sqlite::provider{file};
+        bulk_load(state, to);
+    }
+    std::remove(file.c_str());
+}
+BENCHMARK(synthetic_bulk_load)
+    ->ArgsProduct({{100'000, 1'000'000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Indexed rowset (id, wkb) of synthetic polygons, made in memory once
+const db::rowset& synthetic_rowset(size_t features)
+{
+    static std::map<size_t, db::rowset> cache;
+    auto& res = cache[features];
+    if (res.columns.empty()) {
+        auto opts = synthetic::options{};
+        opts.features = features;
+        opts.type = synthetic::shape::Polygon;
+        auto gen = synthetic::generator{opts};
+        db::variant_ostream os;
+        for (size_t i = 0; i < features; ++i)
+            os << i << blob_view{gen()};
+        res = {{"id", "wkb"}, std::move(os.data)};
+        db::index(res);
+    }
+    return res;
+}
+
+/// Decoding by the calling thread and range(1) - 1 workers
+template <class Functor>
+void synthetic_decode(benchmark::State& state, Functor decode)
+{
+    auto& rs = synthetic_rowset(state.range(0));
+    auto threads = unsigned(state.range(1));
+    auto exec = executor{std::max(1u, threads - 1)};
+    auto grain = threads > 1 ? 1024 : size_t(state.range(0));  // one range
+    for (auto _ : state)
+        benchmark::DoNotOptimize(decode(rs, 1, exec, grain));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * rs.data.size());
+}
+
+void synthetic_decode_geometries(benchmark::State& state)
+{
+    synthetic_decode(state, db::decode_geometries);
+}
+BENCHMARK(synthetic_decode_geometries)
+    ->ArgsProduct({{100'000, 1'000'000}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void synthetic_decode_coords(benchmark::State& state)
+{
+    synthetic_decode(state, db::decode_coords);
+}
+BENCHMARK(synthetic_decode_coords)
+    ->ArgsProduct({{100'000, 1'000'000}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+#if defined(BARK_TEST_POSTGRES_SERVER) && defined(BARK_TEST_DATABASE_PWD)
+/// Streaming (1) against a plain fetch (0). Run one mode per process to
+/// compare the peak RSS, it never goes down.
+void postgres_fetch(benchmark::State& state)
+{
+    auto cmd = db::postgres::command{
+        BOOST_PP_STRINGIZE(BARK_TEST_POSTGRES_SERVER),
+        5432,
+        "postgres",
+        "postgres",
+        BOOST_PP_STRINGIZE(BARK_TEST_DATABASE_PWD)};
+    cmd.set_streaming(state.range(1));
+    auto sql = concat("SELECT i, repeat('x', 100)::bytea FROM "
+                      "generate_series(1, ",
+                      state.range(0),
+                      ") AS i");
+    size_t bytes = 0;
+    for (auto _ : state) {
+        db::exec(cmd, sql);
+        bytes += db::fetch_all(cmd).data.size();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(bytes);
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    state.counters["max_rss_kb"] = double(usage.ru_maxrss);
+}
+BENCHMARK(postgres_fetch)
+    ->ArgsProduct({{10'000, 100'000, 1'000'000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+void postgres_bulk_load(benchmark::State& state)
+{
+    auto to = db::postgres::provider{
+        BOOST_PP_STRINGIZE(BARK_TEST_POSTGRES_SERVER),
+        5432,
+        "postgres",
+        "postgres",
+        BOOST_PP_STRINGIZE(BARK_TEST_DATABASE_PWD)};
+    bulk_load(state, to);
+}
+BENCHMARK(postgres_bulk_load)
+    ->ArgsProduct({{100'000, 1'000'000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#endif
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -3,11 +3,16 @@
 #ifndef BARK_TEST_DB_HPP
 #define BARK_TEST_DB_HPP
 
+#include <bark/db/copier.hpp>
+#include <bark/geometry/envelope.hpp>
+#include <bark/geometry/geom_from_wkb.hpp>
+#include <bark/geometry/geometry_ops.hpp>
 #include <bark/test/providers.hpp>
 #include <bark/test/simplify_geometry.hpp>
 #include <boost/io/ios_state.hpp>
 #include <boost/preprocessor/stringize.hpp>
 #include <boost/range/algorithm/equal.hpp>
+#include <cstdio>
 #include <iostream>
 
 namespace bark::db {
@@ -88,10 +93,219 @@ TEST_CASE("db_insert")
         auto rows = fetch_all(*pvd, select_sql(*pvd, tbl_nm, 0, 100500));
         simplify_geometry_column(rows, lr_src.back());
         REQUIRE(rows_src == rows);
+        rowset pages;
+        for_each_page(*pvd, tbl_nm, 2, [&](const rowset& page) {
+            pages.columns = page.columns;
+            pages.data.insert(
+                pages.data.end(), page.data.begin(), page.data.end());
+        });
+        simplify_geometry_column(pages, lr_src.back());
+        REQUIRE(rows_src == pages);
+        auto [copy_nm, copy_ddl] =
+            pvd->ddl({id(concat("drop_me_", random_index{10000}())),
+                      tbl_src.columns,
+                      tbl_src.indexes});
+        exec(*pvd, copy_ddl);
+        pvd->refresh();
+        auto col_nms = names(tbl_src.columns);
+        auto opts = copying_options{};
+        opts.readers = 2;
+        auto stats =
+            copy_table(*pvd, tbl_nm, col_nms, *pvd, copy_nm, col_nms, opts);
+        std::cout << stats << std::endl;
+        REQUIRE(stats.rows == select(rows_src).size());
+        REQUIRE(tbl_src == pvd->table(copy_nm));  // indexes are rebuilt
+        auto copy = fetch_all(*pvd, select_sql(*pvd, copy_nm, 0, 100500));
+        simplify_geometry_column(copy, lr_src.back());
+        REQUIRE(rows_src == copy);
+        exec(*pvd, drop_sql(*pvd, copy_nm));
         exec(*pvd, drop_sql(*pvd, tbl_nm));
         pvd->refresh();
         REQUIRE_THROWS(pvd->table(tbl_nm));
     }
 }
 
+TEST_CASE("db_gdal_export")
+{
+    using namespace bark;
+    using namespace bark::db;
+    auto pvd_src = gdal::provider{"./data/mexico.sqlite"};
+    auto lr_src = pvd_src.dir().begin()->first;
+    auto tbl_src = pvd_src.table(qualifier(lr_src));
+    auto rows_src =
+        fetch_all(pvd_src, select_sql(pvd_src, tbl_src.name, 0, 100500));
+    auto pk = boost::range::find_if(tbl_src.indexes,
+                                    same{meta::index_type::Primary});
+    REQUIRE(pk != tbl_src.indexes.end());
+    auto attrs = std::vector<std::string>{pk->columns.front(), "name"};
+    auto sorted = [&](const rowset& rows) {
+        auto res = select(attrs, rows);
+        std::sort(res.begin(), res.end());
+        return res;
+    };
+    for (auto ext : {"shp", "fgb"}) {
+        // single-layer formats, the layer is named by the file
+        for (auto del : {"dbf", "fgb", "prj", "qix", "shp", "shx"})
+            std::remove(concat("./drop_me_export.", del).c_str());
+        auto file = concat("./drop_me_export.", ext);
+        auto [tbl_nm, ddl] = pvd_src.ddl(
+            {id("drop_me_export"), tbl_src.columns, tbl_src.indexes});
+        gdal::create(file, ddl);
+        auto pvd = gdal::provider{file};
+        exec(pvd, insert_sql(pvd, tbl_nm, rows_src));
+        pvd.refresh();
+        auto rows = fetch_all(pvd, select_sql(pvd, tbl_nm, 0, 100500));
+        CHECK(sorted(rows_src) == sorted(rows));
+    }
+}
+
+TEST_CASE("db_copy_same_database")
+{
+    using namespace bark;
+    using namespace bark::db;
+    auto pvd = sqlite::provider{R"(./drop_me.sqlite)"};
+    auto src_nm = id(concat("drop_me_", random_index{10000}(), "_src"));
+    auto dst_nm = id(concat("drop_me_", random_index{10000}(), "_dst"));
+    for (auto& tbl_nm : {src_nm, dst_nm})
+        exec(pvd,
+             builder(pvd) << "CREATE TABLE " << tbl_nm
+                          << " (id INTEGER PRIMARY KEY, val TEXT)");
+    // more than the page cache, so the writer locks the file
+    exec(pvd,
+         builder(pvd) << "WITH RECURSIVE seq(i) AS (SELECT 1 UNION ALL "
+                         "SELECT i + 1 FROM seq WHERE i < 200000) INSERT INTO "
+                      << src_nm << " SELECT i, printf('%0100d', i) FROM seq");
+    pvd.refresh();
+    auto col_nms = std::vector<std::string>{"id", "val"};
+    auto count = [&] {
+        return select(fetch_all(
+            pvd, builder(pvd) << "SELECT COUNT(1) FROM " << dst_nm))[0][0];
+    };
+    auto opts = copying_options{};
+    opts.readers = 4;
+    auto stats = copy_table(pvd, src_nm, col_nms, pvd, dst_nm, col_nms, opts);
+    std::cout << stats << std::endl;
+    REQUIRE(stats.rows == 200000);
+    REQUIRE(count() == variant_t{int64_t{200000}});
+    exec(pvd, builder(pvd) << "DELETE FROM " << dst_nm);
+    auto other = sqlite::provider{R"(./drop_me.sqlite)"};
+    opts.serial = true;
+    stats = copy_table(pvd, src_nm, col_nms, other, dst_nm, col_nms, opts);
+    REQUIRE(stats.rows == 200000);
+    REQUIRE(count() == variant_t{int64_t{200000}});
+    exec(pvd, builder(pvd) << "DELETE FROM " << dst_nm);
+    auto heap_nm = id(concat("drop_me_", random_index{10000}(), "_heap"));
+    exec(pvd,
+         builder(pvd) << "CREATE TABLE " << heap_nm << " AS SELECT * FROM "
+                      << src_nm);  // without primary key
+    pvd.refresh();
+    stats = copy_table(pvd, heap_nm, col_nms, pvd, dst_nm, col_nms, opts);
+    REQUIRE(stats.rows == 200000);
+    REQUIRE(count() == variant_t{int64_t{200000}});
+    for (auto& tbl_nm : {src_nm, dst_nm, heap_nm})
+        exec(pvd, drop_sql(pvd, tbl_nm));
+}
+
+TEST_CASE("db_sqlite_spatial_index")
+{
+    using namespace bark;
+    using namespace bark::db;
+    auto pvd = sqlite::provider{R"(./drop_me.sqlite)"};
+    auto tbl = concat("drop_me_", random_index{10000}(), "_idx");
+    auto lr_nm = id(tbl, "geom");
+    exec(pvd,
+         builder(pvd) << "CREATE TABLE " << id(tbl)
+                      << " (id INTEGER PRIMARY KEY)");
+    exec(pvd,
+         builder(pvd) << "SELECT AddGeometryColumn(" << param{tbl}
+                      << ", 'geom', 4326, 'POINT')");
+    exec(pvd,
+         builder(pvd) << "WITH RECURSIVE seq(i) AS (SELECT 1 UNION ALL "
+                         "SELECT i + 1 FROM seq WHERE i < "
+                      << sqlite_dialect::IndexRows << ") INSERT INTO "
+                      << id(tbl) << " SELECT i, MakePoint(i % 360 - 180, "
+                      << "i % 180 - 90, 4326) FROM seq");
+    // the estimate, so the statistics are known without a scan
+    exec(pvd,
+         builder(pvd) << "SELECT UpdateLayerStatistics(" << param{tbl}
+                      << ", 'geom')");
+    pvd.refresh();
+    REQUIRE(pvd.spatial_index_advised(lr_nm));
+    pvd.build_spatial_index(lr_nm);
+    REQUIRE_FALSE(pvd.spatial_index_advised(lr_nm));
+    exec(pvd, drop_sql(pvd, id(tbl)));
+}
+
+TEST_CASE("db_cached_sub_tile")
+{
+    using namespace bark;
+    using namespace bark::db;
+    auto pvd = gdal::provider{"./data/mexico.sqlite"};
+    auto lr = pvd.dir().begin()->first;
+    auto ext = pvd.extent(lr);
+    auto px = geometry::box{ext.min_corner(), ext.min_corner()};
+    std::vector<rowset> tiles;
+    std::vector<std::vector<variant_t>> rows;
+    for (auto& tile : pvd.tile_coverage(lr, ext, px))
+        for (auto& row : select(tiles.emplace_back(
+                 pvd.spatial_objects(lr, tile, px))))
+            rows.push_back(row);
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    auto center = boost::geometry::return_centroid<geometry::point>(ext);
+    for (auto sub : {geometry::box{ext.min_corner(), center},
+                     geometry::box{center, center}}) {
+        auto expected = rows;
+        expected.erase(
+            std::remove_if(expected.begin(),
+                           expected.end(),
+                           [&](auto& row) {
+                               return !boost::geometry::intersects(
+                                   sub,
+                                   geometry::envelope(geometry::geom_from_wkb(
+                                       std::get<blob_view>(row[0]))));
+                           }),
+            expected.end());
+        auto objects = pvd.spatial_objects(lr, sub, px);
+        auto actual = select(objects);
+        std::sort(actual.begin(), actual.end());
+        CHECK(actual == expected);
+    }
+}
+
+TEST_CASE("db_pick")
+{
+    using namespace bark;
+    using namespace bark::db;
+    auto pvd = gdal::provider{"./data/mexico.sqlite"};
+    auto lr = pvd.dir().begin()->first;
+    auto ext = pvd.extent(lr);
+    auto px = geometry::box{ext.min_corner(), ext.min_corner()};
+    auto center = boost::geometry::return_centroid<geometry::point>(ext);
+    auto cursor = geometry::box{center, center};
+    auto window = pvd.spatial_objects(lr, cursor, px);
+    auto expected = select(window);
+    expected.erase(std::remove_if(expected.begin(),
+                                  expected.end(),
+                                  [&](auto& row) {
+                                      return !geometry::intersects(
+                                          geometry::geom_from_wkb(
+                                              std::get<blob_view>(row[0])),
+                                          cursor);
+                                  }),
+                   expected.end());
+    std::sort(expected.begin(), expected.end());
+    CHECK(!expected.empty());
+    auto uncached = pvd.pick(lr, cursor, px);
+    for (auto& tile : pvd.tile_coverage(lr, ext, px))
+        pvd.spatial_objects(lr, tile, px);
+    auto cached = pvd.pick(lr, cursor, px);
+    for (auto objects : {uncached, cached}) {
+        auto actual = select(objects);
+        std::sort(actual.begin(), actual.end());
+        CHECK(actual == expected);
+    }
+}
+
 #endif  // BARK_TEST_DB_HPP
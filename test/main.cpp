@@ -6,8 +6,13 @@
 
 #include <bark/test/db.hpp>
 #include <bark/test/geometry.hpp>
+#include <bark/test/mbtiles.hpp>
+#include <bark/test/mvt.hpp>
 #include <bark/test/proj.hpp>
 #include <bark/test/raster.hpp>
+#include <bark/test/rowset.hpp>
+#include <bark/test/snapshot.hpp>
 #include <bark/test/sql_builder.hpp>
+#include <bark/test/trace.hpp>
 #include <bark/test/unicode.hpp>
 #include <bark/test/wkt.hpp>
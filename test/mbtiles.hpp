@@ -0,0 +1,45 @@
+// Andrew Naplavkov
+
+#ifndef BARK_TEST_MBTILES_HPP
+#define BARK_TEST_MBTILES_HPP
+
+#include <bark/db/slippy/seeder.hpp>
+#include <cstdio>
+
+TEST_CASE("mbtiles_seed")
+{
+    using namespace bark;
+    using namespace bark::db;
+
+    constexpr auto File = "drop_me.mbtiles";
+    std::remove(File);
+    auto lon_lat = geometry::box{{-10, -10}, {10, 10}};
+    auto encode = [](const slippy::tile& tl) {
+        return tl.x % 2 ? blob{} : blob(tl.z + 1, std::byte{42});
+    };
+    {
+        slippy::mbtiles dest(File);
+        auto stats =
+            slippy::seed(dest, "test", "pbf", lon_lat, 0, 3, encode, 3);
+        CHECK(stats.skipped == 0);
+        CHECK(stats.stored > 0);
+        CHECK(stats.empty > 0);
+        CHECK(dest.stored(0, 3).size() == stats.stored + stats.empty);
+        CHECK(dest.stored(0, 0).size() == 1);
+        CHECK(dest.stored(0, 0).front().y == 0);
+    }
+    {
+        slippy::mbtiles dest(File);
+        auto stats =
+            slippy::seed(dest, "test", "pbf", lon_lat, 0, 4, encode, 2);
+        CHECK(stats.skipped == dest.stored(0, 3).size());
+        CHECK(stats.stored + stats.empty == dest.stored(4, 4).size());
+        CHECK(dest.metadata("name") == "test");
+        CHECK(dest.metadata("format") == "pbf");
+        CHECK(dest.metadata("bounds") == "-10,-10,10,10");
+        CHECK(dest.metadata("minzoom") == "0");
+        CHECK(dest.metadata("maxzoom") == "4");
+    }
+}
+
+#endif  // BARK_TEST_MBTILES_HPP
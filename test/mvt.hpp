@@ -0,0 +1,43 @@
+// Andrew Naplavkov
+
+#ifndef BARK_TEST_MVT_HPP
+#define BARK_TEST_MVT_HPP
+
+#include <algorithm>
+#include <bark/db/slippy/mvt.hpp>
+#include <bark/geometry/as_binary.hpp>
+#include <bark/geometry/geom_from_text.hpp>
+
+TEST_CASE("mvt")
+{
+    using namespace bark;
+    using namespace bark::db;
+
+    // tile grid matches coordinates with y axis flipped
+    auto lr = slippy::mvt_layer{"test", {{0, 0}, {4096, 4096}}};
+    auto add = [&](const char* wkt, variant_t attr) {
+        auto wkb = geometry::as_binary(geometry::geom_from_text(wkt));
+        lr.add({"wkb", "attr"}, {blob_view{wkb}, attr});
+    };
+    add("POINT(25 4079)", int64_t{42});
+    add("LINESTRING(2 4094,2 4086,10 4086)", "road");
+    add("POLYGON((3 4090,8 4084,20 4062,3 4090))", "road");
+    add("POINT(-1000 -1000)", "clipped");
+    REQUIRE(!lr.empty());
+
+    auto msg = lr.message().data;
+    auto contains = [&](std::initializer_list<int> bytes) {
+        auto seq = as<blob>(bytes, [](int b) { return std::byte(b); });
+        return std::search(msg.begin(), msg.end(), seq.begin(), seq.end()) !=
+               msg.end();
+    };
+
+    // @see https://github.com/mapbox/vector-tile-spec/tree/master/2.1
+    CHECK(contains({0x22, 3, 9, 50, 34}));
+    CHECK(contains({0x22, 8, 9, 4, 4, 18, 0, 16, 16, 0}));
+    CHECK(contains({0x22, 9, 9, 6, 12, 18, 10, 12, 24, 44, 15}));
+    CHECK(contains({0x12, 2, 0, 1}));  // shared "road" value
+    CHECK(!contains({'c', 'l', 'i', 'p', 'p', 'e', 'd'}));
+}
+
+#endif  // BARK_TEST_MVT_HPP
@@ -0,0 +1,119 @@
+// Andrew Naplavkov
+
+#ifndef BARK_TEST_ROWSET_HPP
+#define BARK_TEST_ROWSET_HPP
+
+#include <bark/db/rowset.hpp>
+#include <bark/db/wkb_decoder.hpp>
+#include <bark/geometry/as_binary.hpp>
+#include <bark/geometry/as_text.hpp>
+#include <bark/geometry/geom_from_text.hpp>
+#include <bark/test/wkt.hpp>
+#include <type_traits>
+
+TEST_CASE("rowset_index")
+{
+    using namespace bark;
+    using namespace bark::db;
+
+    rowset rs{{"id", "name", "val"}, {}};
+    variant_ostream os;
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < 50; ++i)
+        names.push_back(concat("row ", i));
+    for (int64_t i = 0; i < 50; ++i) {
+        os << i << std::string_view{names[i]};
+        if (i % 2)
+            os << variant_t{};
+        else
+            os << blob_view{blob(i, std::byte(i))};
+    }
+    rs.data = std::move(os.data);
+    auto rows = select(rs);
+    CHECK(!indexed(rs));
+    CHECK(row_count(rs) == 50);
+
+    index(rs);
+    REQUIRE(indexed(rs));
+    CHECK(rs.offsets.size() == 50 * 3 + 1);
+    CHECK(rs.offsets.back() == rs.data.size());
+    CHECK(row_count(rs) == 50);
+    CHECK(select(rs) == rows);
+    CHECK(get(rs, 42, 0) == variant_t{int64_t(42)});
+    CHECK(get(rs, 42, 1) == variant_t{std::string_view{"row 42"}});
+    CHECK(is_null(get(rs, 41, 2)));
+    CHECK_THROWS(get(rs, 50, 0));
+    CHECK(select(rs, 10, 20) ==
+          decltype(rows)(rows.begin() + 10, rows.begin() + 20));
+
+    auto part = slice(rs, 48, 50);
+    CHECK(row_count(part) == 2);
+    CHECK(part.offsets.front() == 0);
+    CHECK(part.offsets.back() == part.data.size());
+    CHECK(select(part) == decltype(rows)(rows.end() - 2, rows.end()));
+    CHECK(row_count(slice(rs, 7, 7)) == 0);
+}
+
+namespace bark::geometry {
+
+/// Appends x, y pairs of all vertices in the order of WKB
+inline void append_coords(const geometry& geom, std::vector<double>& dest)
+{
+    boost::apply_visitor(
+        [&](const auto& item) {
+            using T = std::decay_t<decltype(item)>;
+            if constexpr (std::is_same_v<T, geometry_collection>)
+                for (auto& part : item)
+                    append_coords(part, dest);
+            else
+                boost::geometry::for_each_point(item, [&](auto& pt) {
+                    dest.push_back(pt.x());
+                    dest.push_back(pt.y());
+                });
+        },
+        geom);
+}
+
+}  // namespace bark::geometry
+
+TEST_CASE("rowset_decode_geometries")
+{
+    using namespace bark;
+    using namespace bark::db;
+
+    std::vector<blob> wkbs;
+    for (int i = 0; i < 20; ++i)
+        for (auto&& wkt : Wkt)
+            wkbs.push_back(geometry::as_binary(geometry::geom_from_text(wkt)));
+    rowset rs{{"id", "wkb"}, {}};
+    variant_ostream os;
+    for (size_t i = 0; i < wkbs.size(); ++i)
+        os << i << blob_view{wkbs[i]};
+    rs.data = std::move(os.data);
+
+    executor exec{3};
+    for (bool idx : {false, true}) {
+        if (idx)
+            index(rs);
+        auto geoms = decode_geometries(rs, 1, exec, 7);
+        REQUIRE(geoms.size() == wkbs.size());
+        auto flat = decode_coords(rs, 1, exec, 7);
+        REQUIRE(flat.offsets.size() == wkbs.size() + 1);
+        CHECK(flat.offsets.back() == flat.coords.size());
+        for (size_t i = 0; i < wkbs.size(); ++i) {
+            CHECK(geometry::as_binary(geoms[i]) == wkbs[i]);
+            std::vector<double> coords;
+            geometry::append_coords(geoms[i], coords);
+            CHECK(std::equal(coords.begin(),
+                             coords.end(),
+                             flat.coords.begin() + flat.offsets[i],
+                             flat.coords.begin() + flat.offsets[i + 1]));
+        }
+    }
+    CHECK_THROWS_AS(decode_geometries(rs, 0, exec), std::bad_variant_access);
+    CHECK_THROWS_AS(decode_geometries(rs, 2, exec), std::out_of_range);
+    exec.shutdown();  // the calling thread decodes alone
+    CHECK(decode_geometries(rs, 1, exec, 7).size() == wkbs.size());
+}
+
+#endif  // BARK_TEST_ROWSET_HPP
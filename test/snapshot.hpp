@@ -0,0 +1,113 @@
+// Andrew Naplavkov
+
+#ifndef BARK_TEST_SNAPSHOT_HPP
+#define BARK_TEST_SNAPSHOT_HPP
+
+#include <bark/db/snapshot.hpp>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+bark::db::rowset make_snapshot_rowset()
+{
+    using namespace bark;
+    using namespace bark::db;
+    rowset res{{"id", "name", "geom", "val"}, {}};
+    variant_ostream os;
+    for (int64_t i = 0; i < 100; ++i) {
+        auto name = concat("row ", i);
+        auto wkb = blob(i % 7, std::byte(i));
+        os << i << std::string_view{name} << blob_view{wkb};
+        if (i % 3)
+            os << variant_t{};
+        else
+            os << i / 2.;
+    }
+    res.data = std::move(os.data);
+    return res;
+}
+
+}  // namespace
+
+TEST_CASE("snapshot_round_trip")
+{
+    using namespace bark;
+    using namespace bark::db;
+
+    auto rs = make_snapshot_rowset();
+    auto bytes = make_snapshot(rs);
+    REQUIRE(bytes.size() % 8 == 0);
+    REQUIRE(is_snapshot(bytes));
+    snapshot_view view{bytes};
+    CHECK(view.columns() == rs.columns);
+    CHECK(view.size() == 100);
+    auto rows = select(view);
+    CHECK(rows == select(rs));
+    CHECK(std::get<std::string_view>(rows[42][1]) == "row 42");
+    CHECK(rowset(view).data == rs.data);
+    index(rs);
+    CHECK(make_snapshot(rs) == bytes);
+
+    auto empty = make_snapshot(rowset{{"id"}, {}});
+    CHECK(snapshot_view{empty}.size() == 0);
+}
+
+TEST_CASE("snapshot_mapped_file")
+{
+    using namespace bark::db;
+
+    constexpr auto File = "drop_me.snapshot";
+    auto rs = make_snapshot_rowset();
+    save_snapshot(rs, File);
+    {
+        mapped_snapshot snap{File};
+        CHECK(snap->columns() == rs.columns);
+        CHECK(select(*snap) == select(rs));
+    }
+    std::remove(File);
+}
+
+TEST_CASE("snapshot_validation")
+{
+    using namespace bark;
+    using namespace bark::db;
+
+    auto bytes = make_snapshot(make_snapshot_rowset());
+    auto corrupt = [&](size_t pos, std::byte val) {
+        auto res = bytes;
+        res[pos] = val;
+        return res;
+    };
+    CHECK(!is_snapshot(blob{}));
+    CHECK(!is_snapshot(corrupt(0, std::byte{'X'})));
+    CHECK(!is_snapshot(corrupt(8, std::byte{2})));  // version
+    CHECK(!is_snapshot(corrupt(16, std::byte{5})));  // columns
+    CHECK(!is_snapshot(blob(bytes.begin(), bytes.end() - 8)));
+    CHECK_THROWS_AS(snapshot_view{corrupt(24, std::byte{99})},
+                    std::runtime_error);
+}
+
+TEST_CASE("snapshot_fuzz")
+{
+    using namespace bark;
+    using namespace bark::db;
+
+    auto bytes = make_snapshot(make_snapshot_rowset());
+    std::mt19937 gen{0};
+    for (int i = 0; i < 2000; ++i) {
+        auto sample = bytes;
+        for (int j = 0, n = 1 + gen() % 4; j < n; ++j)
+            sample[gen() % sample.size()] = std::byte(gen());
+        if (gen() % 4 == 0)
+            sample.resize(gen() % sample.size() / 8 * 8);
+        if (!is_snapshot(sample))
+            continue;
+        // consistent snapshots must be readable to the last value
+        snapshot_view view{sample};
+        for (auto& row : select(view))
+            CHECK(row.size() == view.columns_size());
+    }
+}
+
+#endif  // BARK_TEST_SNAPSHOT_HPP
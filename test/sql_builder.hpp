@@ -3,6 +3,8 @@
 #ifndef BARK_TEST_SQL_BUILDER_HPP
 #define BARK_TEST_SQL_BUILDER_HPP
 
+#include <bark/db/detail/sqlite_dialect.hpp>
+#include <bark/db/gdal/detail/statement.hpp>
 #include <bark/db/sql_builder.hpp>
 #include <bark/geometry/as_binary.hpp>
 #include <boost/lexical_cast.hpp>
@@ -20,4 +22,145 @@ TEST_CASE("sql_builder_params")
           "Hello!, 0, Bark, 1, 93 bytes");
 }
 
+TEST_CASE("sql_builder_embedded")
+{
+    using namespace bark;
+    using namespace bark::db;
+    using namespace std::string_literals;
+
+    sql_builder bld{[](auto id) { return concat('"', id, '"'); }, nullptr};
+    bld << "SELECT " << id("a", "b") << ", " << param{"text"s} << ", "
+        << param{0.1} << ", " << param{-42} << ", " << param{variant_t{}}
+        << ", " << param{blob{std::byte{0x0f}, std::byte{0xa0}}} << " "
+        << 'x' << true;
+    CHECK(bld.sql() == R"(SELECT "a"."b", 'text', 0.1, -42, NULL, X'0FA0' x1)");
+    CHECK(bld.params().empty());
+}
+
+TEST_CASE("sql_builder_reuse")
+{
+    using namespace bark;
+    using namespace bark::db;
+    using namespace std::string_literals;
+
+    sql_builder bld{nullptr, [](auto) { return "?"; }};
+    for (int i = 0; i < 3; ++i) {
+        bld.clear();
+        bld << "VALUES (" << param{std::to_string(i)} << ", " << param{i}
+            << ")";
+        auto copy = bld;
+        bld.clear();
+        CHECK(copy.sql() == "VALUES (?, ?)");
+        CHECK(boost::lexical_cast<std::string>(list{copy.params(), ", "}) ==
+              concat(i, ", ", i));
+        bld = copy;
+    }
+    auto text = std::get<std::string_view>(bld.params().front());
+    CHECK(text.data()[text.size()] == '\0');
+}
+
+TEST_CASE("sql_builder_gdal_insertion")
+{
+    using namespace bark;
+    using namespace bark::db;
+    using namespace std::string_literals;
+
+    sql_builder bld{[](auto id) { return concat('"', id, '"'); },
+                    [](auto) { return "?"; }};
+    bld << "INSERT INTO " << id("main", "a b") << " (" << id("x y") << ", "
+        << id("z") << ") VALUES\n(" << param{1} << "," << param{"'?'"s}
+        << "),\n(" << param{2} << "," << param{variant_t{}} << ")";
+    auto ins = gdal::parse_insertion(bld.sql(), bld.params().size());
+    REQUIRE(ins);
+    CHECK(ins->table == "a b");
+    CHECK(ins->columns == std::vector<std::string>{"x y", "z"});
+    CHECK(ins->rows == 2);
+    CHECK(!gdal::parse_insertion(bld.sql(), 3));
+    CHECK(gdal::parse_insertion(R"(INSERT INTO "a""b" (c) VALUES (?))", 1)
+              ->table == "a\"b");
+    CHECK(!gdal::parse_insertion("INSERT INTO t (a) VALUES (?) x", 1));
+    CHECK(!gdal::parse_insertion("INSERT INTO t (a) SELECT ?", 1));
+
+    bld.clear();
+    bld << "SELECT '?', \"?\", " << param{"it's"s} << ", "
+        << param{blob{std::byte{0xff}}};
+    CHECK(gdal::read_only(bld.sql()));
+    CHECK(gdal::embed(bld.sql(), bld.params()) ==
+          R"(SELECT '?', "?", 'it''s', X'FF')");
+}
+
+TEST_CASE("sql_builder_gdal_ddl")
+{
+    using namespace bark::db::gdal;
+
+    auto stmts = split(R"(CREATE TABLE "t;" (
+	"geom" geometry(4326),
+	"id" integer,
+	"name" text,
+	PRIMARY KEY ("id")
+);
+CREATE SPATIAL INDEX ON "t;" ("geom");
+)");
+    REQUIRE(stmts.size() == 2);
+    auto def = parse_create_table(stmts[0]);
+    REQUIRE(def);
+    CHECK(def->table == "t;");
+    CHECK(def->columns ==
+          decltype(def->columns){
+              {"geom", "geometry(4326)"}, {"id", "integer"}, {"name", "text"}});
+    CHECK(def->primary_key == std::vector<std::string>{"id"});
+    CHECK(!parse_spatial_index(stmts[0]));
+    auto idx = parse_spatial_index(stmts[1]);
+    REQUIRE(idx);
+    CHECK(idx->table == "t;");
+    CHECK(idx->column == "geom");
+    CHECK(!parse_drop_spatial_index(stmts[1]));
+    auto drop =
+        parse_drop_spatial_index(R"(DROP SPATIAL INDEX ON "t;" (geom))");
+    REQUIRE(drop);
+    CHECK(drop->table == "t;");
+    CHECK(drop->column == "geom");
+    CHECK(!parse_create_table("CREATE TABLE t (a integer"));
+    CHECK(!read_only(stmts[1]));
+}
+
+TEST_CASE("sql_builder_sqlite_window")
+{
+    using namespace bark;
+    using namespace bark::db;
+
+    auto window = [](const meta::table& tbl, const geometry::box& ext) {
+        sql_builder bld{[](auto id) { return concat('"', id, '"'); },
+                        [](auto) { return "?"; }};
+        sqlite_dialect{}.window_clause(bld, tbl, "geom", ext);
+        return std::string{bld.sql()};
+    };
+    auto rtree = [](const std::string& sql) {
+        return sql.find("rowid IN") != std::string::npos;
+    };
+
+    meta::table tbl;
+    tbl.name = id("roads");
+    auto& col = tbl.columns.emplace_back();
+    col.name = "geom";
+    col.type = meta::column_type::Geometry;
+    auto small = geometry::box{{1, 1}, {2, 2}};
+    auto large = geometry::box{{-10, -10}, {80, 80}};
+    CHECK(!rtree(window(tbl, small)));
+
+    tbl.indexes.push_back({meta::index_type::Secondary, {"geom"}});
+    col.tiles = {[] { return geometry::box_rtree{}; }, std::nullopt};
+    CHECK(rtree(window(tbl, large)));  // unknown statistics
+
+    col.tiles = make_tiles(100 * RowsPerTile, {{0, 0}, {100, 100}});
+    auto stats = statistics(tbl, "geom");
+    REQUIRE(stats);
+    CHECK(stats->indexed);
+    CHECK(stats->rows >= 100 * RowsPerTile);
+    CHECK(sqlite_dialect::selectivity(*stats, large) ==
+          Approx(.8 * .8).epsilon(1e-9));
+    CHECK(rtree(window(tbl, small)));
+    CHECK(!rtree(window(tbl, large)));
+}
+
 #endif  // BARK_TEST_SQL_BUILDER_HPP
@@ -0,0 +1,283 @@
+// Andrew Naplavkov
+
+#ifndef BARK_TEST_SYNTHETIC_HPP
+#define BARK_TEST_SYNTHETIC_HPP
+
+#include <algorithm>
+#include <bark/db/gdal/detail/utility.hpp>
+#include <bark/db/gdal/provider.hpp>
+#include <bark/db/provider.hpp>
+#include <bark/geometry/as_binary.hpp>
+#include <bark/proj/epsg.hpp>
+#include <boost/math/constants/constants.hpp>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/// Reproducible datasets of any size for scale testing.
+
+/// Coordinates depend only on @ref synthetic::options, because they are
+/// derived from the raw std::mt19937 sequence and not from the
+/// implementation-defined distributions.
+namespace bark::synthetic {
+
+enum class shape { Point, Line, Polygon };
+
+struct options {
+    size_t features = 10000;
+    shape type = shape::Point;
+    size_t vertices = 16;  ///< of a line or a polygon ring
+    double skew = 0;  ///< share of features in hot spots [0, 1]
+    size_t hot_spots = 8;
+    double feature_size = 0.001;  ///< fraction of the extent
+    geometry::box extent{{-118, 14}, {-86, 33}};  ///< in EPSG:4326
+    uint32_t seed = 0;
+    size_t batch = 1000;  ///< rows per INSERT statement
+};
+
+class generator {
+public:
+    explicit generator(const options& opts) : opts_{opts}, gen_{opts.seed}
+    {
+        for (size_t i = 0; i < opts_.hot_spots; ++i)
+            spots_.push_back(uniform_point());
+    }
+
+    blob operator()()
+    {
+        auto center = spot();
+        switch (opts_.type) {
+            case shape::Point:
+                return geometry::as_binary(center);
+            case shape::Line:
+                return geometry::as_binary(line(center));
+            case shape::Polygon:
+                return geometry::as_binary(ring(center));
+        }
+        throw std::logic_error("synthetic shape");
+    }
+
+    /// [0, 1)
+    double canonical() { return gen_() / (double(gen_.max()) + 1); }
+
+private:
+    static constexpr auto Pi = boost::math::constants::pi<double>();
+    const options opts_;
+    std::mt19937 gen_;
+    std::vector<geometry::point> spots_;
+
+    double width() const
+    {
+        return opts_.extent.max_corner().x() - opts_.extent.min_corner().x();
+    }
+
+    double height() const
+    {
+        return opts_.extent.max_corner().y() - opts_.extent.min_corner().y();
+    }
+
+    geometry::point uniform_point()
+    {
+        auto& min = opts_.extent.min_corner();
+        return {min.x() + canonical() * width(),
+                min.y() + canonical() * height()};
+    }
+
+    geometry::point spot()
+    {
+        if (spots_.empty() || canonical() >= opts_.skew)
+            return uniform_point();
+        auto& hot = spots_[size_t(canonical() * spots_.size())];
+        auto radius = 0.01 * canonical();
+        auto angle = 2 * Pi * canonical();
+        return clamp({hot.x() + radius * width() * std::cos(angle),
+                      hot.y() + radius * height() * std::sin(angle)});
+    }
+
+    geometry::point clamp(const geometry::point& p) const
+    {
+        auto& min = opts_.extent.min_corner();
+        auto& max = opts_.extent.max_corner();
+        return {std::clamp(p.x(), min.x(), max.x()),
+                std::clamp(p.y(), min.y(), max.y())};
+    }
+
+    /// Random walk
+    geometry::linestring line(geometry::point p)
+    {
+        auto step = opts_.feature_size / std::max<size_t>(opts_.vertices, 2);
+        geometry::linestring res{p};
+        while (res.size() < std::max<size_t>(opts_.vertices, 2)) {
+            p = clamp({p.x() + (canonical() - .5) * step * width(),
+                       p.y() + (canonical() - .5) * step * height()});
+            res.push_back(p);
+        }
+        return res;
+    }
+
+    /// Star-shaped counterclockwise ring
+    geometry::polygon ring(const geometry::point& center)
+    {
+        auto count = std::max<size_t>(opts_.vertices, 3);
+        geometry::polygon res;
+        for (size_t i = 0; i < count; ++i) {
+            auto angle = 2 * Pi * i / count;
+            auto radius = opts_.feature_size * (.5 + canonical()) / 2;
+            res.outer().push_back(
+                clamp({center.x() + radius * width() * std::cos(angle),
+                       center.y() + radius * height() * std::sin(angle)}));
+        }
+        res.outer().push_back(res.outer().front());
+        return res;
+    }
+};
+
+/// Creates a table (id, geom, val, name) with a spatial index and fills it.
+
+/// @return the name of the geometry layer.
+inline db::qualified_name make_layer(db::provider& pvd,
+                                     std::string_view table_name,
+                                     const options& opts)
+{
+    using namespace db;
+    auto column = [](std::string nm, meta::column_type type) {
+        meta::column res;
+        res.name = std::move(nm);
+        res.type = type;
+        if (type == meta::column_type::Geometry)
+            res.projection = proj::epsg().find_proj(4326);
+        return res;
+    };
+    auto cols = std::vector<meta::column>{
+        column("id", meta::column_type::Integer),
+        column("geom", meta::column_type::Geometry),
+        column("val", meta::column_type::Real),
+        column("name", meta::column_type::Text)};
+    auto idxs =
+        std::vector<meta::index>{{meta::index_type::Primary, {"id"}},
+                                 {meta::index_type::Secondary, {"geom"}}};
+    auto [tbl_nm, ddl] = pvd.ddl({id(table_name), cols, idxs});
+    exec(pvd, ddl);
+    pvd.refresh();
+
+    auto col_nms = names(cols);
+    auto cmd = pvd.make_command();
+    cmd->set_autocommit(false);
+    generator gen{opts};
+    std::vector<blob> wkbs;
+    std::vector<std::string> texts;
+    std::vector<std::vector<variant_t>> rows;
+    for (size_t first = 0; first < opts.features; first += opts.batch) {
+        auto count = std::min(opts.batch, opts.features - first);
+        wkbs.clear();
+        texts.clear();
+        rows.clear();
+        for (size_t i = 0; i < count; ++i) {
+            wkbs.push_back(gen());
+            texts.push_back(concat("feature ", first + i));
+        }
+        for (size_t i = 0; i < count; ++i)
+            rows.push_back({int64_t(first + i),
+                            blob_view{wkbs[i]},
+                            gen.canonical(),
+                            std::string_view{texts[i]}});
+        exec(*cmd, insert_sql(pvd, tbl_nm, col_nms, rows));
+    }
+    cmd->commit();
+    pvd.refresh();
+    return id(tbl_nm, "geom");
+}
+
+/// Creates a GeoPackage with the layer of @ref make_layer.
+
+/// @param file has the .gpkg extension, the driver is chosen by it.
+/// @return the name of the geometry layer.
+inline db::qualified_name make_gpkg(const std::string& file,
+                                    std::string_view table_name,
+                                    const options& opts)
+{
+    db::gdal::create(file);
+    auto pvd = db::gdal::provider{file};
+    return make_layer(pvd, table_name, opts);
+}
+
+/// Writes a tiled GeoTIFF in EPSG:4326 with overviews
+inline void make_geotiff(const std::string& file,
+                         int width,
+                         int height,
+                         const geometry::box& extent = options{}.extent,
+                         uint32_t seed = 0)
+{
+    using namespace db::gdal;
+    static constexpr int Bands = 3;
+    static constexpr int Block = 256;
+    GDALAllRegister();
+    auto drv = GDALGetDriverByName("GTiff");
+    check(!!drv);
+    const char* opts[] = {
+        "TILED=YES", "BLOCKXSIZE=256", "BLOCKYSIZE=256", nullptr};
+    dataset_holder ds{GDALCreate(
+        drv, file.c_str(), width, height, Bands, GDT_Byte, (char**)opts)};
+    check(!!ds);
+
+    auto& min = extent.min_corner();
+    auto& max = extent.max_corner();
+    double tf[] = {min.x(),
+                   (max.x() - min.x()) / width,
+                   0,
+                   max.y(),
+                   0,
+                   -(max.y() - min.y()) / height};
+    check(GDALSetGeoTransform(ds.get(), tf));
+    spatial_reference_holder srs{OSRNewSpatialReference(nullptr)};
+    check(OSRImportFromEPSG(srs.get(), 4326));
+    char* wkt = nullptr;
+    check(OSRExportToWkt(srs.get(), &wkt));
+    vsi_holder wkt_holder{wkt};
+    check(GDALSetProjection(ds.get(), wkt));
+
+    // smooth gradients with noise, so compression and resampling do work
+    std::mt19937 gen{seed};
+    std::vector<uint8_t> buf(Block * Block);
+    for (int band = 1; band <= Bands; ++band) {
+        auto hband = GDALGetRasterBand(ds.get(), band);
+        for (int y0 = 0; y0 < height; y0 += Block)
+            for (int x0 = 0; x0 < width; x0 += Block) {
+                auto cols = std::min(Block, width - x0);
+                auto rows = std::min(Block, height - y0);
+                for (int y = 0; y < rows; ++y)
+                    for (int x = 0; x < cols; ++x)
+                        buf[y * cols + x] =
+                            uint8_t((x0 + x) * band / 16 + (y0 + y) / 16 +
+                                    gen() % 16);
+                check(GDALRasterIO(hband,
+                                   GF_Write,
+                                   x0,
+                                   y0,
+                                   cols,
+                                   rows,
+                                   buf.data(),
+                                   cols,
+                                   rows,
+                                   GDT_Byte,
+                                   0,
+                                   0));
+            }
+    }
+
+    int levels[] = {2, 4, 8, 16, 32};
+    check(GDALBuildOverviews(ds.get(),
+                             "AVERAGE",
+                             std::size(levels),
+                             levels,
+                             0,
+                             nullptr,
+                             nullptr,
+                             nullptr));
+}
+
+}  // namespace bark::synthetic
+
+#endif  // BARK_TEST_SYNTHETIC_HPP
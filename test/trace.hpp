@@ -0,0 +1,81 @@
+// Andrew Naplavkov
+
+#ifndef BARK_TEST_TRACE_HPP
+#define BARK_TEST_TRACE_HPP
+
+#include <algorithm>
+#include <bark/detail/trace.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST_CASE("trace")
+{
+    using namespace bark;
+
+    static trace::site scope_site{"test::scope"};
+    static trace::site counter_site{"test::counter"};
+    trace::start();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([] {
+            for (int j = 0; j < 1000; ++j) {
+                trace::scope scp{scope_site};
+                counter_site.add(2);
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+    trace::stop();
+
+    auto stats = trace::snapshot();
+    auto find = [&](const char* name) {
+        return *std::find_if(stats.begin(), stats.end(), [&](auto& st) {
+            return st.name == name;
+        });
+    };
+    CHECK(find("test::scope").count == 4000);
+    CHECK(find("test::scope").max <= find("test::scope").total);
+    CHECK(find("test::counter").count == 8000);
+
+    std::ostringstream os;
+    trace::write_chrome_json(os);
+    auto json = os.str();
+    CHECK(json.rfind("{\"traceEvents\":[", 0) == 0);
+    CHECK(json.find("\"name\":\"test::scope\",\"ph\":\"X\"") !=
+          std::string::npos);
+    // every thread counts on its own
+    CHECK(json.find("\"args\":{\"value\":2000}") != std::string::npos);
+    CHECK(trace::dropped() == 0);
+
+    trace::reset();
+    stats = trace::snapshot();
+    CHECK(find("test::scope").count == 0);
+    CHECK(find("test::counter").count == 0);
+    os.str({});
+    trace::write_chrome_json(os);
+    CHECK(os.str() == "{\"traceEvents\":[]}");
+}
+
+#ifdef BARK_TRACE
+TEST_CASE("trace_macros")
+{
+    using namespace bark;
+
+    trace::reset();
+    for (int i = 0; i < 3; ++i) {
+        BARK_TRACE_SCOPE("test::macro_scope");
+        BARK_TRACE_COUNTER("test::macro_counter", 5);
+    }
+    auto stats = trace::snapshot();
+    auto find = [&](const char* name) {
+        return *std::find_if(stats.begin(), stats.end(), [&](auto& st) {
+            return st.name == name;
+        });
+    };
+    CHECK(find("test::macro_scope").count == 3);
+    CHECK(find("test::macro_counter").count == 15);
+}
+#endif
+
+#endif  // BARK_TEST_TRACE_HPP